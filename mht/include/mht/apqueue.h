@@ -57,7 +57,10 @@
  *     double getNextSolutionCost()                                  *
  *       Returns the cost of the next solution that will be returned *
  *       by getNextSolution() (see below).  This does not remove the *
- *       solution from the list.                                     *
+ *       solution from the list.  If a cost limit has been set (see  *
+ *       setCostLimit()), and the next solution is known to cost     *
+ *       more than the limit, this may return a lower bound on its   *
+ *       cost instead.                                               *
  *                                                                   *
  *     void *getNextSolution( VECTOR_OF< void * > &solutionTag,      *
  *                            int *solutionSize )                    *
@@ -67,6 +70,37 @@
  *       solution itself is returned in the way described in         *
  *       assign.H (the way FindBestAssignment() returns it).         *
  *                                                                   *
+ *     void setAssignmentMethod( ASSIGN_METHOD method )              *
+ *       Choose the algorithm used to solve problems (see assign.H). *
+ *                                                                   *
+ *     void setDualInheritance( int inherit )                        *
+ *       If 'inherit' is 1, subproblems are solved starting from     *
+ *       the solutions of the problems they were partitioned from,   *
+ *       and problems are partitioned in the order described below.  *
+ *       This always uses the shortest-path method.  Queues that     *
+ *       haven't been given a setting follow SetDualInheritance(),   *
+ *       which is 0 until it is called.                              *
+ *                                                                   *
+ *     void setLowerBounds( int useBounds )                          *
+ *       If 'useBounds' is 1, each subproblem made by partitioning   *
+ *       gets a lower bound on its cost (see below), rather than     *
+ *       just the cost of its parent.  Queues that haven't been      *
+ *       given a setting follow SetLowerBounds(), which is 0 until   *
+ *       it is called.                                               *
+ *                                                                   *
+ *     void setCostLimit( double costLimit )                         *
+ *       Say that solutions costing more than 'costLimit' will not   *
+ *       be asked for.  Subproblems whose lower bounds are above the *
+ *       limit are then left unsolved by isEmpty() and               *
+ *       getNextSolutionCost() (getNextSolution() still solves them, *
+ *       if asked).  The limit lasts until removeAllProblems() is    *
+ *       called.                                                     *
+ *                                                                   *
+ *     long getNumAvoidedSolves()                                    *
+ *       Returns the number of subproblems that have been thrown     *
+ *       away unsolved, by removeProblem() or removeAllProblems(),   *
+ *       because their lower bounds were above the cost limit.       *
+ *                                                                   *
  * IMPLEMENTATION NOTES:                                             *
  *                                                                   *
  *   I'm using Murty's algorithm for ranked assignments, described   *
@@ -126,6 +160,80 @@
  *   The rest of the solution is computed by a call to               *
  *   FindBestAssignment().                                           *
  *                                                                   *
+ *   The pairs don't keep their own copies of the possible           *
+ *   assignments.  When a problem is added, its arcs are copied once *
+ *   into an apqPROBLEM object, which is shared by all the pairs     *
+ *   that come from partitioning it.  Each pair records only how its *
+ *   problem differs from the original one: a list of arcs that have *
+ *   been removed (the <r,c,s>'s that were removed to make P'), and  *
+ *   the list of arcs in the base solution, whose rows and columns   *
+ *   have been removed.  The arcs of a pair's problem are only put   *
+ *   together, in the queue's scratch space, when it is solved.  The *
+ *   apqPROBLEM also indexes its arcs by tag, row and column, so     *
+ *   partitioning doesn't have to search through them.  This means   *
+ *   that the tags in one problem must all be different.             *
+ *                                                                   *
+ *   The problem/solution pairs are kept on a list, and the list     *
+ *   order is used to break ties between pairs whose solutions are   *
+ *   equally good (the one nearest the head wins).  New problems go  *
+ *   on the head of the list, and the pairs made by partitioning     *
+ *   take the place of the pair that was partitioned.  So that we    *
+ *   don't have to walk the list to find the best pair, the pairs    *
+ *   are also kept in a binary heap, ordered by cost, then by        *
+ *   whether they've been solved yet (solved ones first), then by    *
+ *   number of possible assignments (fewer first), and finally by    *
+ *   list position.  List positions are kept as integer labels that  *
+ *   increase from head to tail, and are respaced locally when a new *
+ *   pair lands between two neighbors with adjacent labels (this is  *
+ *   the "order maintenance" scheme of Dietz & Sleator, as           *
+ *   simplified by Bender et al.).  The pairs for each problem are   *
+ *   also indexed by their problemTag, so removeProblem() only       *
+ *   touches the pairs that it removes.                              *
+ *                                                                   *
+ *   With dual inheritance turned on, two of the optimizations from  *
+ *                                                                   *
+ *     M. L. Miller, H. S. Stone and I. J. Cox                       *
+ *     Optimizing Murty's ranked assignment method                   *
+ *     IEEE Transactions on Aerospace and Electronic Systems,        *
+ *     33(3):851-862                                                 *
+ *     1997                                                          *
+ *                                                                   *
+ *   are used.  First, every problem is solved by shortest paths,    *
+ *   and the potentials and matching of its solution are kept (in    *
+ *   an apqDUALS, shared by the subproblems it is partitioned into). *
+ *   P' differs from P only by the removal of <r,c,s> and of some    *
+ *   rows and columns, so the old potentials are still feasible for  *
+ *   it, and most of the old matching can be kept.  Solving P' then  *
+ *   takes a shortest-path search from each row that lost its mate,  *
+ *   which is usually just r (and r's anti-column, see assign.C).    *
+ *   Second, the reduced costs under those potentials give, for each *
+ *   <r,c,s> in S, a lower bound on how much more the best solution  *
+ *   without <r,c,s> will cost: the cheapest other arc out of r plus *
+ *   the cheapest other arc into c.  The arcs are removed in order   *
+ *   of decreasing bound.  So the subproblem likeliest to hold the   *
+ *   next solution is made last, when the most rows and columns have *
+ *   been taken out of P, and is the smallest one to solve and to    *
+ *   partition again.  It also lands nearest the head of the list.   *
+ *                                                                   *
+ *   A pair isn't solved until it reaches the top of the heap, so    *
+ *   the better the lower bound it starts with, the less likely it   *
+ *   is to be solved at all.  With lower bounds turned on, the bound *
+ *   on P' is its base cost plus the larger of two sums: the cost of *
+ *   the cheapest arc out of every row left in P', and the cost of   *
+ *   the cheapest arc into every column (each row and column must    *
+ *   be covered by exactly one arc; the arcs that leave columns, or  *
+ *   rows, unassigned count only if their costs are negative).  If   *
+ *   dual inheritance is on too, the cost of S plus the slack for    *
+ *   <r,c,s> described above is also a bound (it is worked out on P  *
+ *   before any arcs are moved into the base solution, and P' is a   *
+ *   subproblem of P minus <r,c,s>).  The largest of these bounds,   *
+ *   and the cost of S, is used.                                     *
+ *                                                                   *
+ *   Each ASSIGNMENT_PQUEUE solves its problems in its own           *
+ *   ASSIGNMENT_SOLVER (see assign.H), so different queues may be    *
+ *   used at the same time in different threads.  The algorithm it   *
+ *   uses can be set with setAssignmentMethod().                     *
+ *                                                                   *
  * ----------------------------------------------------------------- *
  *                                                                   *
  *             Copyright (c) 1993, NEC Research Institute            *
@@ -161,14 +269,117 @@
 #include "list.h"
 #include "assign.h"
 #include <assert.h>
+#include <vector>			// for std::vector<>
+#include <unordered_map>		// for std::unordered_map<>
 
 /*-------------------------------------------------------------------*
  | Declarations of stuff found in this file.
  *-------------------------------------------------------------------*/
 
+class apqPROBLEM;
+class apqDUALS;
 class apqSOLUTION;
 class ASSIGNMENT_PQUEUE;
 
+/*-------------------------------------------------------------------*
+ | apqPROBLEM -- original assignment problem, shared by all the
+ |               problem/solution pairs made from it
+ *-------------------------------------------------------------------*/
+
+class apqPROBLEM
+{
+    friend class apqSOLUTION;
+    friend class ASSIGNMENT_PQUEUE;
+
+private:
+
+    void *m_problemTag;              // id of original problem
+    ROW_COL_COST *m_rcc;             // all possible assignments
+    int m_numRCCs;                   // number of possible assignments
+    int m_numRows;                   // number of rows
+    int m_numCols;                   // number of columns
+    int m_numUsers;                  // number of apqSOLUTION's using
+    //   this problem
+
+    VECTOR_OF< int > m_firstArcOfRow;    // arcs of row r are
+    VECTOR_OF< int > m_arcOfRow;         //   m_arcOfRow[ m_firstArcOfRow[ r ]
+    //   ... m_firstArcOfRow[ r + 1 ] - 1 ]
+    VECTOR_OF< int > m_firstArcOfCol;    // same for columns
+    VECTOR_OF< int > m_arcOfCol;
+    std::unordered_map< void *, int > m_arcForTag;
+
+    VECTOR_OF< char > m_arcIsExcluded;   // marks for one subproblem
+    VECTOR_OF< char > m_rowIsFixed;      //   at a time (see
+    VECTOR_OF< char > m_colIsFixed;      //   markSubproblem())
+
+private:
+
+    apqPROBLEM( void *problemTag,
+                ROW_COL_COST *rcc,
+                int numRCCs,
+                int numRows,
+                int numCols );
+
+    ~apqPROBLEM()
+    {
+        delete [] m_rcc;
+    }
+
+    apqPROBLEM( const apqPROBLEM & );
+    apqPROBLEM &operator=( const apqPROBLEM & );
+
+    int findArc( void *tag )
+    {
+        std::unordered_map< void *, int >::iterator entry =
+            m_arcForTag.find( tag );
+        return entry == m_arcForTag.end() ? -1 : entry->second;
+    }
+
+    void markSubproblem( const int *excludedArc, int numExcludedArcs,
+                         const int *baseArc, int numBaseArcs );
+    void unmarkSubproblem( const int *excludedArc, int numExcludedArcs,
+                           const int *baseArc, int numBaseArcs );
+    void fixArc( int arc );
+
+    int arcIsInSubproblem( int arc )
+    {
+        int row = m_rcc[ arc ].row;
+        int col = m_rcc[ arc ].col;
+
+        return ! m_arcIsExcluded[ arc ] &&
+               (row < 0 || ! m_rowIsFixed[ row ]) &&
+               (col < 0 || ! m_colIsFixed[ col ]);
+    }
+};
+
+/*-------------------------------------------------------------------*
+ | apqDUALS -- potentials and matching from the solution of one
+ |             problem/solution pair, shared by the pairs made by
+ |             partitioning it
+ *-------------------------------------------------------------------*/
+
+class apqDUALS
+{
+    friend class apqSOLUTION;
+
+private:
+
+    ASSIGNMENT_DUALS m_duals;
+    int m_numUsers;                  // number of apqSOLUTION's using
+    //   these duals
+
+private:
+
+    apqDUALS():
+        m_duals(),
+        m_numUsers( 1 )
+    {
+    }
+
+    apqDUALS( const apqDUALS & );
+    apqDUALS &operator=( const apqDUALS & );
+};
+
 /*-------------------------------------------------------------------*
  | apqSOLUTION -- problem/solution pair (see header comments above)
  *-------------------------------------------------------------------*/
@@ -179,7 +390,7 @@ class apqSOLUTION: public DLISTnode
 
 private:
 
-    void *m_problemTag;              // id of original problem
+    apqPROBLEM *m_problem;           // original problem
     double m_baseCost;               // cost of "base" part of solution
     double m_cost;                   // total cost of solution
     int m_solutionSize;              // total solution size
@@ -187,66 +398,47 @@ private:
     int m_baseSolutionSize;          // the first m_baseSolutionSize
     //   assignments in m_solutionTag
     //   form the "base" solution
-    void **m_baseSolutionTag;        // storage for the "base" solution
-    //   before the problem is really
-    //   solved
-    ROW_COL_COST *m_rcc;             // possible assignments
+    int *m_baseArc;                  // arcs in the "base" solution
+    //   (indices into m_problem)
+    int *m_excludedArc;              // arcs removed from m_problem
+    int m_numExcludedArcs;           //   by partitioning
     int m_numRCCs;                   // number of possible assignments
-    int m_numRows;                   // number of rows
-    int m_numCols;                   // number of columns
+    apqDUALS *m_duals;               // duals of this pair's solution,
+    //   or, before it's solved, of
+    //   its parent's (0 if not kept)
+
+    unsigned long long m_order;      // label giving position on list
+    int m_heapIndex;                 // position in the queue's heap
+    int m_problemIndex;              // position in the queue's index
+    //   of pairs for the problem
 
 private:
 
-    apqSOLUTION( void *problemTag,
+    apqSOLUTION( apqPROBLEM *problem,
                  double baseCost,
-                 double parentCost,
-                 void **baseSolutionTag,
+                 double lowerBound,
+                 const int *baseArc,
                  int baseSolutionSize,
-                 ROW_COL_COST *rcc,
+                 const int *excludedArc,
+                 int numExcludedArcs,
+                 int newExcludedArc,
                  int numRCCs,
-                 int numRows,
-                 int numCols ):
-        m_problemTag( problemTag ),
-        m_baseCost( baseCost ),
-        m_cost( 0 ),
-        m_solutionSize( 0 ),
-        m_solutionTag( 0 ),
-        m_baseSolutionSize( baseSolutionSize ),
-        m_baseSolutionTag( 0 ),
-        m_rcc( new ROW_COL_COST[ numRCCs ] ),
-        m_numRCCs( numRCCs ),
-        m_numRows( numRows ),
-        m_numCols( numCols )
-    {
-        setup( baseSolutionTag, rcc, parentCost );
-    }
+                 apqDUALS *duals );
 
-    apqSOLUTION( void *problemTag,
-                 ROW_COL_COST *rcc,
-                 int numRCCs,
-                 int numRows,
-                 int numCols ):
-        m_problemTag( problemTag ),
-        m_baseCost( 0 ),
-        m_cost( 0 ),
-        m_solutionSize( 0 ),
-        m_solutionTag( 0 ),
-        m_baseSolutionSize( 0 ),
-        m_baseSolutionTag( 0 ),
-        m_rcc( new ROW_COL_COST[ numRCCs ] ),
-        m_numRCCs( numRCCs ),
-        m_numRows( numRows ),
-        m_numCols( numCols )
-    {
-        setup( 0, rcc );
-    }
+    apqSOLUTION( apqPROBLEM *problem );
 
     ~apqSOLUTION()
     {
 
         delete [] m_solutionTag;
-        delete [] m_baseSolutionTag;
-        delete [] m_rcc;
+        delete [] m_baseArc;
+        delete [] m_excludedArc;
+        releaseDuals();
+
+        if( --m_problem->m_numUsers == 0 )
+        {
+            delete m_problem;
+        }
     }
 
     int isSolved() const
@@ -254,11 +446,22 @@ private:
         return m_solutionTag != 0;
     }
 
-    void setup( void **baseSolutionTag,
-                ROW_COL_COST *rcc,
-                double parentCost = -INFINITY );
-    void solve( void );
-    void partition();
+    void releaseDuals()
+    {
+        if( m_duals != 0 && --m_duals->m_numUsers == 0 )
+        {
+            delete m_duals;
+        }
+        m_duals = 0;
+    }
+
+    void solve( ASSIGNMENT_SOLVER &solver,
+                VECTOR_OF< ROW_COL_COST > &rcc,
+                VECTOR_OF< void * > &solutionTag,
+                int inheritDuals );
+    double lowestPossibleCost( int doomedArc );
+    void orderPartition( VECTOR_OF< double > &removalBound );
+    void partition( int useLowerBounds );
 
     int isValid()
     {
@@ -267,7 +470,7 @@ private:
 
     void *getProblemTag()
     {
-        return m_problemTag;
+        return m_problem->m_problemTag;
     }
     double getCost()
     {
@@ -280,6 +483,8 @@ private:
         return m_numRCCs;
     }
 
+    int isBetterThan( const apqSOLUTION &other ) const;
+
     void print();
 
 protected:
@@ -298,10 +503,75 @@ private:
 
     iDLIST_OF< apqSOLUTION > m_solutionList;
     apqSOLUTION *m_bestSolution;
+    int m_dualInheritanceIsSet;          // 0 to follow SetDualInheritance()
+    int m_dualInheritance;               // 1 to solve subproblems starting
+    //   from their parents' duals
+    int m_lowerBoundsAreSet;             // 0 to follow SetLowerBounds()
+    int m_lowerBounds;                   // 1 to give subproblems lower
+    //   bounds on their costs
+    double m_costLimit;                  // subproblems with lower bounds
+    //   above this aren't solved
+    long m_numAvoidedSolves;             // subproblems thrown away
+    //   unsolved because of the limit
+    ASSIGNMENT_SOLVER m_solver;          // workspace for solving problems
+    VECTOR_OF< ROW_COL_COST > m_rcc;     // scratch space for problems
+    VECTOR_OF< void * > m_solutionTag;   // scratch space for solutions
+
+    std::vector< apqSOLUTION * > m_heap; // pairs, best one first
+    std::unordered_map< void *, std::vector< apqSOLUTION * > >
+    m_problemIndex;                      // pairs for each problemTag
 
 public:
 
-    ASSIGNMENT_PQUEUE(): m_solutionList(), m_bestSolution( 0 ) {}
+    ASSIGNMENT_PQUEUE():
+        m_solutionList(),
+        m_bestSolution( 0 ),
+        m_dualInheritanceIsSet( 0 ),
+        m_dualInheritance( 0 ),
+        m_lowerBoundsAreSet( 0 ),
+        m_lowerBounds( 0 ),
+        m_costLimit( INFINITY ),
+        m_numAvoidedSolves( 0 ),
+        m_solver(),
+        m_rcc(),
+        m_solutionTag(),
+        m_heap(),
+        m_problemIndex()
+    {
+    }
+
+    void setAssignmentMethod( ASSIGN_METHOD method )
+    {
+        m_solver.setMethod( method );
+    }
+
+    void setDualInheritance( int inherit )
+    {
+        m_dualInheritance = inherit;
+        m_dualInheritanceIsSet = 1;
+    }
+    int getDualInheritance() const;
+
+    void setLowerBounds( int useBounds )
+    {
+        m_lowerBounds = useBounds;
+        m_lowerBoundsAreSet = 1;
+    }
+    int getLowerBounds() const;
+
+    void setCostLimit( double costLimit )
+    {
+        m_costLimit = costLimit;
+    }
+    double getCostLimit() const
+    {
+        return m_costLimit;
+    }
+
+    long getNumAvoidedSolves() const
+    {
+        return m_numAvoidedSolves;
+    }
 
     void addProblem( void *problemTag,
                      ROW_COL_COST *rcc,
@@ -311,15 +581,11 @@ public:
 
     void removeProblem( void *problemTag );
 
-    void removeAllProblems()
-    {
-
-        m_solutionList.removeAll();
-    }
+    void removeAllProblems();
 
     int isEmpty()
     {
-        findBestSolution();
+        findBestSolution( m_costLimit );
         return m_solutionList.isEmpty() ||
                m_bestSolution->getCost() == INFINITY;
     }
@@ -327,7 +593,7 @@ public:
     double getNextSolutionCost()
     {
 
-        findBestSolution();
+        findBestSolution( m_costLimit );
 
 #ifdef TSTBUG
         // NOTE: Assertion boolean was negated from original for the if-statement
@@ -343,8 +609,35 @@ public:
 
 private:
 
-    void findBestSolution();
+    ASSIGNMENT_PQUEUE( const ASSIGNMENT_PQUEUE & );
+    ASSIGNMENT_PQUEUE &operator=( const ASSIGNMENT_PQUEUE & );
+
+    void findBestSolution( double costLimit );
+    void countAvoidedSolve( apqSOLUTION *solution );
+
+    void insertSolutions( apqSOLUTION *first, int count );
+    void removeSolution( apqSOLUTION *solution );
+    void placeInOrder( apqSOLUTION *first, int count );
+    void spaceOrderAround( apqSOLUTION *first, int count );
+
+    void heapRemove( apqSOLUTION *solution );
+    void heapUp( int index );
+    void heapDown( int index );
+    void heapSet( int index, apqSOLUTION *solution )
+    {
+        m_heap[ index ] = solution;
+        solution->m_heapIndex = index;
+    }
 };
 
+/*-------------------------------------------------------------------*
+ | Routine prototypes
+ *-------------------------------------------------------------------*/
+
+void SetDualInheritance( int inherit );
+int GetDualInheritance();
+void SetLowerBounds( int useBounds );
+int GetLowerBounds();
+
 #endif
 
@@ -96,6 +96,52 @@
  *   of the assignment found.  If there are no solutions, then       *
  *   FindBestAssignment() returns UNSOLVABLE.                        *
  *                                                                   *
+ *                     SetAssignmentMethod()                         *
+ *                                                                   *
+ *   FindBestAssignment() can use either of two algorithms, chosen   *
+ *   at run time with SetAssignmentMethod() --                       *
+ *                                                                   *
+ *     HUNGARIAN_ASSIGN -- The Cooper & Steinberg Hungarian method   *
+ *       (the default).                                              *
+ *                                                                   *
+ *     SHORTEST_PATH_ASSIGN -- Successive shortest augmenting paths, *
+ *       found with Dijkstra's algorithm over the sparse list of     *
+ *       arcs, using row and column potentials.  This is much        *
+ *       faster on large problems.                                   *
+ *                                                                   *
+ *   Both give a lowest-cost solution, but when several solutions    *
+ *   have the same cost they need not pick the same one.             *
+ *   GetAssignmentMethod() returns the current choice.               *
+ *                                                                   *
+ *                     ASSIGNMENT_SOLVER                             *
+ *                                                                   *
+ *   All the working storage for solving problems is kept in an      *
+ *   ASSIGNMENT_SOLVER object, whose findBestAssignment() member     *
+ *   takes the same arguments as FindBestAssignment().  The storage  *
+ *   is kept between calls, so it only needs to be allocated when a  *
+ *   bigger problem comes along.  FindBestAssignment() uses one      *
+ *   shared solver, so code that solves problems in several threads  *
+ *   at once should give each thread its own ASSIGNMENT_SOLVER.      *
+ *   A solver uses the method given to SetAssignmentMethod() unless  *
+ *   it has been given its own with setMethod().                     *
+ *                                                                   *
+ *                     ASSIGNMENT_DUALS                              *
+ *                                                                   *
+ *   A second version of ASSIGNMENT_SOLVER::findBestAssignment()     *
+ *   always uses the shortest-path method, and leaves the row and    *
+ *   column potentials and the matching it finds in an               *
+ *   ASSIGNMENT_DUALS object.  If it is then given a subproblem of   *
+ *   that problem (one with some arcs, rows or columns removed,      *
+ *   using the same row and column numbers), along with those        *
+ *   ASSIGNMENT_DUALS, it starts from the old potentials and         *
+ *   matching instead of from scratch.  The old potentials are still *
+ *   feasible for the subproblem, and most of the old matching is    *
+ *   still usable, so only the rows that lost their mates need to be *
+ *   given new ones.  ASSIGNMENT_DUALS::getReducedCost() gives the   *
+ *   reduced cost of an arc under the potentials, which is a lower   *
+ *   bound on how much the cost of a solution goes up if that arc is *
+ *   forced into it.                                                 *
+ *                                                                   *
  * EXAMPLE:                                                          *
  *                                                                   *
  *   Code for an easy assignment problem --                          *
@@ -192,6 +238,8 @@
 #include <math.h>
 #include "except.h"
 #include "vector.h"
+#include "queue.h"
+#include "pqueue.h"
 
 #ifdef DECLARE_ASSIGN
 #define GLOBAL
@@ -204,6 +252,16 @@ GLOBAL long G_totalAssignSizes;
 GLOBAL long G_maxAssignSize;
 static const double UNSOLVABLE = INFINITY;
 
+/*-------------------------------------------------------------------*
+ | ASSIGN_METHOD -- algorithms available to FindBestAssignment()
+ *-------------------------------------------------------------------*/
+
+enum ASSIGN_METHOD
+{
+    HUNGARIAN_ASSIGN,
+    SHORTEST_PATH_ASSIGN
+};
+
 /*-------------------------------------------------------------------*
  | ROW_COL_COST -- structure for representing a possible assignment
  *-------------------------------------------------------------------*/
@@ -256,14 +314,252 @@ struct ROW_COL_COST
     }
 };
 
+/*-------------------------------------------------------------------*
+ | ASSIGNMENT_DUALS -- potentials and matching left by the
+ |                     shortest-path method, for starting on a
+ |                     subproblem (see header comments above)
+ *-------------------------------------------------------------------*/
+
+class ASSIGNMENT_DUALS
+{
+    friend class ASSIGNMENT_SOLVER;
+
+private:
+
+    int m_minRow, m_maxRow;          // range of rows and columns
+    int m_minCol, m_maxCol;          //   covered (empty if no solution
+                                     //   has been saved)
+
+    VECTOR_OF< double > m_rowPotential; // dual variable for each row
+    VECTOR_OF< double > m_colPotential; // dual variable for each column
+    VECTOR_OF< int > m_mateForRow;   // column each row was assigned to
+    VECTOR_OF< double > m_costOfMate; // cost of each row's assignment
+
+public:
+
+    ASSIGNMENT_DUALS():
+        m_minRow( 0 ),
+        m_maxRow( -1 ),
+        m_minCol( 0 ),
+        m_maxCol( -1 )
+    {
+    }
+
+    int isEmpty() const
+    {
+        return m_maxRow < m_minRow;
+    }
+
+    double getReducedCost( const ROW_COL_COST &rcc );
+
+private:
+
+    ASSIGNMENT_DUALS( const ASSIGNMENT_DUALS & );
+    ASSIGNMENT_DUALS &operator=( const ASSIGNMENT_DUALS & );
+};
+
+/*-------------------------------------------------------------------*
+ | ASSIGNMENT_SOLVER -- workspace for solving assignment problems
+ |
+ | All of the working storage used by FindBestAssignment() lives in
+ | one of these.  The arrays grow to fit the biggest problem solved so
+ | far, and are reused from one call to the next.  Separate solvers
+ | share nothing, so each thread can solve problems with its own.
+ *-------------------------------------------------------------------*/
+
+class ASSIGNMENT_SOLVER
+{
+private:
+
+    /* a column waiting to be scanned by shortestPath(), and the cost
+       of the shortest path found to it so far */
+    struct PATH_COST
+    {
+        double cost;
+        int col;
+        int colIsFree;
+
+        /* PQUEUE_OF<> gives the largest object first, so the cheapest
+           path is made the "largest" -- ties go first to unassigned
+           columns, which end the search, and then to the lowest column
+           number, to keep the search deterministic */
+        int operator>( const PATH_COST &other ) const
+        {
+            if( cost != other.cost )
+            {
+                return cost < other.cost;
+            }
+            if( colIsFree != other.colIsFree )
+            {
+                return colIsFree;
+            }
+            return col < other.col;
+        }
+    };
+
+    int m_methodIsSet;               // 0 to follow SetAssignmentMethod()
+    ASSIGN_METHOD m_method;          // algorithm, if m_methodIsSet
+
+    long m_numCalls;                 // statistics, like G_numAssignCalls,
+    long m_totalSizes;               //   etc., but for this solver only
+    long m_maxSize;
+
+    int m_minRow, m_maxRow;          // range of row numbers that
+                                     //   appear in rcc's
+    int m_minCol, m_maxCol;          // range of column numbers that
+                                     //   appear in rcc's
+
+    VECTOR_OF< ROW_COL_COST > m_rcc; // list of rcc's in problem
+    int m_numRCCs;                   // number of rcc's in problem
+
+    int m_numAssignmentsNeeded;      // number of assignments required
+                                     //   for a complete solution
+    int m_numAssignmentsMade;        // number of assignments that have
+                                     //   been made so far
+
+    VECTOR_OF< double > m_minCostInRow; // minimum cost of possible
+                                     //   assignments for rows
+    VECTOR_OF< double > m_minCostInCol; // minimum cost of possible
+                                     //   assignments for columns
+
+    VECTOR_OF< VECTOR_OF< int > > m_possMateForRow; // This is a two
+                                     //   dimensional array.
+                                     //   m_possMateForRow[r][i] is the
+                                     //   column number of the i'th
+                                     //   column that may be assigned to
+                                     //   row r (counting only those
+                                     //   rcc's that are currently
+                                     //   enabled)
+    VECTOR_OF< int > m_numPossMatesForRow; // number of entries in
+                                     //   m_possMateForRow for each row
+
+    VECTOR_OF< int > m_mateForRow;   // current best column to assign
+                                     //   each row to
+    VECTOR_OF< int > m_mateForCol;   // current best row to assign
+                                     //   each column to
+
+    QUEUE_OF< int > m_rowToSearch;   // next row to search for possible
+                                     //   augmentation
+    VECTOR_OF< int > m_rowPredecessor; // m_rowPredecessor[r] is the
+                                     //   number of the row that led to
+                                     //   row r being searched for an
+                                     //   augmentation
+
+    VECTOR_OF< char > m_rowIsEssential; // labels for essential rows
+    VECTOR_OF< char > m_colIsEssential; // labels for essential columns
+
+    VECTOR_OF< int > m_firstArcOfRow; // m_firstArcOfRow[r] is the index
+                                     //   in m_arcOfRow of the first arc
+                                     //   out of row r
+                                     //   (m_firstArcOfRow[r+1] is one
+                                     //   past its last)
+    VECTOR_OF< int > m_arcOfRow;     // indices into m_rcc, grouped by
+                                     //   row
+
+    VECTOR_OF< double > m_rowPotential; // dual variable for each row
+    VECTOR_OF< double > m_colPotential; // dual variable for each column
+
+    VECTOR_OF< double > m_pathCost;  // reduced cost of the shortest path
+                                     //   found so far to each column
+    VECTOR_OF< int > m_colPredecessor; // row that the shortest path to
+                                     //   each column comes from
+    VECTOR_OF< char > m_colState;    // UNREACHED, REACHED or SCANNED
+    VECTOR_OF< int > m_touchedCol;   // columns that have been reached in
+                                     //   the current search
+    VECTOR_OF< int > m_freeRow;      // rows waiting for a mate during
+                                     //   setupShortestPaths()
+    PQUEUE_OF< PATH_COST > m_colToScan; // reached columns, cheapest first
+                                     //   (may hold stale entries)
+
+public:
+
+    ASSIGNMENT_SOLVER():
+        m_methodIsSet( 0 ),
+        m_method( HUNGARIAN_ASSIGN ),
+        m_numCalls( 0 ),
+        m_totalSizes( 0 ),
+        m_maxSize( 0 ),
+        m_numRCCs( 0 ),
+        m_numAssignmentsNeeded( 0 ),
+        m_numAssignmentsMade( 0 ),
+        m_rowToSearch( 0 )
+    {
+    }
+
+    double findBestAssignment( ROW_COL_COST *rcc, int numRCCs,
+                               int numRows, int numCols,
+                               VECTOR_OF< void * > &tag, int *numTags );
+    double findBestAssignment( ROW_COL_COST *rcc, int numRCCs,
+                               int numRows, int numCols,
+                               ASSIGNMENT_DUALS *startingDuals,
+                               ASSIGNMENT_DUALS &finalDuals,
+                               VECTOR_OF< void * > &tag, int *numTags );
+
+    void setMethod( ASSIGN_METHOD method )
+    {
+        m_method = method;
+        m_methodIsSet = 1;
+    }
+    ASSIGN_METHOD getMethod() const;
+
+    long getNumCalls() const
+    {
+        return m_numCalls;
+    }
+    long getTotalSizes() const
+    {
+        return m_totalSizes;
+    }
+    long getMaxSize() const
+    {
+        return m_maxSize;
+    }
+
+private:
+
+    /* the buffers can't be shared, so solvers can't be copied */
+    ASSIGNMENT_SOLVER( const ASSIGNMENT_SOLVER & );
+    ASSIGNMENT_SOLVER &operator=( const ASSIGNMENT_SOLVER & );
+
+    void countCall( int numRCCs )
+    {
+        m_numCalls++;
+        m_totalSizes += numRCCs;
+        if( numRCCs > m_maxSize )
+        {
+            m_maxSize = numRCCs;
+        }
+    }
+
+    void setupProblem( ROW_COL_COST *rcc, int numRCCs,
+                       int numRows, int numCols );
+    void jumpStartProblem();
+    double solveProblem();
+    int augment();
+    double solveByShortestPaths();
+    void indexArcsByRow();
+    void setupShortestPaths();
+    int startFromDuals( ASSIGNMENT_DUALS &duals );
+    double assignFreeRows();
+    int shortestPath( int freeRow );
+    void saveDuals( ASSIGNMENT_DUALS &duals );
+    double storeSolution( VECTOR_OF< void * > &tag, int *numTags );
+};
+
 /*-------------------------------------------------------------------*
  | Routine prototypes
+ |
+ | FindBestAssignment() solves problems in a single, shared
+ | ASSIGNMENT_SOLVER, so it must not be called from more than one
+ | thread at a time.
  *-------------------------------------------------------------------*/
 
 void SortAssignmentProblem( ROW_COL_COST *rcc, int numRCCs );
 double FindBestAssignment( ROW_COL_COST *rcc, int numRCCs,
                            int numRows, int numCols,
                            VECTOR_OF< void * > &tag, int *numTags );
+void SetAssignmentMethod( ASSIGN_METHOD method );
+ASSIGN_METHOD GetAssignmentMethod();
 
 #undef GLOBAL
 #endif
@@ -45,6 +45,74 @@
 
 #include "assign.h"
 
+typedef
+VECTOR_OF< VECTOR_OF< ROW_COL_COST > >
+RCC_ARRAY_2D;
+
+/*-------------------------------------------------------------------*
+ | BASSIGNMENT_SOLVER -- workspace for the brute-force solver
+ |
+ | Like ASSIGNMENT_SOLVER, this owns all the storage used while
+ | solving, so separate solvers can be used in separate threads.
+ *-------------------------------------------------------------------*/
+
+class BASSIGNMENT_SOLVER
+{
+private:
+
+    int m_minRow;
+    int m_maxRow;
+    int m_minCol;
+    int m_maxCol;
+
+    int m_numRows;
+    int m_numCols;
+
+    RCC_ARRAY_2D m_rccForRow;
+    VECTOR_OF< int > m_numRCCsForRow;
+
+    RCC_ARRAY_2D m_rccForCol;
+    VECTOR_OF< int > m_numRCCsForCol;
+
+    VECTOR_OF< int > m_mateForRow;
+    VECTOR_OF< int > m_mateForCol;
+
+    VECTOR_OF< void * > m_solution;
+    int m_solutionSize;
+
+    VECTOR_OF< void * > m_bestSolution;
+    int m_bestSolutionSize;
+    double m_bestSolutionCost;
+
+public:
+
+    BASSIGNMENT_SOLVER():
+        m_solutionSize( 0 ),
+        m_bestSolutionSize( 0 ),
+        m_bestSolutionCost( INFINITY )
+    {
+    }
+
+    double findBestAssignment( ROW_COL_COST *rcc, int numRCCs,
+                               int numRows, int numCols,
+                               VECTOR_OF< void * > &tag, int *numTags );
+
+private:
+
+    BASSIGNMENT_SOLVER( const BASSIGNMENT_SOLVER & );
+    BASSIGNMENT_SOLVER &operator=( const BASSIGNMENT_SOLVER & );
+
+    void setupProblem( ROW_COL_COST *rcc, int numRCCs, int, int );
+    double solveProblem();
+    void search( int level, double costSoFar );
+    double storeSolution( VECTOR_OF< void * > &tag, int *numTags );
+};
+
+/*-------------------------------------------------------------------*
+ | BFindBestAssignment() -- solve a problem with a single, shared
+ |                          BASSIGNMENT_SOLVER
+ *-------------------------------------------------------------------*/
+
 double BFindBestAssignment( ROW_COL_COST *rcc, int numRCCs,
                             int numRows, int numCols,
                             VECTOR_OF< void * > &tag, int *numTags );
@@ -240,6 +240,21 @@
  *   TYPE &operator*()                                               *
  *     Returns a reference to the first object linked to.            *
  *                                                                   *
+ *                                                                   *
+ *                     LINKS_TO< TYPE, NUM_INLINE >                  *
+ *                                                                   *
+ *   Every link is made of two LINK_NODEs, one in each LINKS_TO<>.   *
+ *   Normally these come from a pool shared by all LINKS_TO<>s.  A   *
+ *   LINKS_TO< TYPE, NUM_INLINE > also has room inside itself for    *
+ *   NUM_INLINE LINK_NODEs, which are used before going to the pool. *
+ *   This is worthwhile for lists that seldom hold more than a few   *
+ *   links, since those links then cost no allocation at all.        *
+ *                                                                   *
+ *   A LINKS_TO< TYPE, NUM_INLINE > is a LINKS_TO< TYPE >, and can be*
+ *   used anywhere that one can (including in MAKE_LINK() and with   *
+ *   PTR_INTO_LINKS_TO< TYPE >).  LINKS_TO< TYPE > is the same as    *
+ *   LINKS_TO< TYPE, 0 >.                                            *
+ *                                                                   *
  *                   PTR_INTO_LINKS_TO< TYPE >                       *
  *                                                                   *
  *   This template defines an iterator for a LINKS_TO<> object.      *
@@ -360,6 +375,7 @@
 #include "except.h"
 #include "list.h"
 #include <assert.h>
+#include <stddef.h>
 
 /*-------------------------------------------------------------------*
  | Declarations of stuff found in this file.
@@ -369,7 +385,7 @@ class LINK_NODE;
 class LINKSbase;
 class PTR_INTO_LINKSbase;
 
-template< class TYPE > class LINKS_TO;
+template< class TYPE, int NUM_INLINE = 0 > class LINKS_TO;
 template< class TYPE > class PTR_INTO_LINKS_TO;
 
 /*-------------------------------------------------------------------*
@@ -379,8 +395,22 @@ template< class TYPE > class PTR_INTO_LINKS_TO;
  | two objects is represented by two LINK_NODEs -- one link node in
  | one object's list, one in the other.  These two nodes are called
  | each other's "partners".
+ |
+ | In memory, every LINK_NODE is preceded by a LINK_HEADER, which says
+ | whether the node lives inside a LINKS_TO<> (see LINK_SLOT, below)
+ | or came from the shared pool.
  *-------------------------------------------------------------------*/
 
+union LINK_HEADER
+{
+    struct
+    {
+        char isInline;               // 1 if in a LINK_SLOT
+        char inUse;                  // 1 if a LINK_SLOT is taken
+    } info;
+    double align;                    // keeps the node aligned
+};
+
 class LINK_NODE: public DLISTnode
 {
     friend class LINKSbase;
@@ -407,6 +437,22 @@ protected:
 public:
 
     ~LINK_NODE();
+
+    static void *operator new( size_t size );
+    static void *operator new( size_t size, LINKSbase &links );
+    static void operator delete( void *node );
+    static void operator delete( void *node, LINKSbase & );
+};
+
+/*-------------------------------------------------------------------*
+ | LINK_SLOT -- room for one LINK_NODE inside a LINKS_TO<>
+ *-------------------------------------------------------------------*/
+
+struct LINK_SLOT
+{
+    LINK_HEADER header;
+    double node[ (sizeof( LINK_NODE ) + sizeof( double ) - 1) /
+                 sizeof( double ) ];
 };
 
 /*-------------------------------------------------------------------*
@@ -415,6 +461,7 @@ public:
 
 class LINKSbase
 {
+    friend class LINK_NODE;
     friend class PTR_INTO_LINKSbase;
     friend void XMakeLinkBase( void *obj0, LINKSbase &links0,
                                void *obj1, LINKSbase &links1 );
@@ -428,6 +475,11 @@ protected:
     LINKSbase(): m_list() {}
     virtual ~LINKSbase() {}
 
+    virtual void *getFreeSlot()
+    {
+        return 0;
+    }
+
     void *baseGetHead() const
     {
         return m_list.getHead()->m_thatObj;
@@ -548,7 +600,7 @@ public:
  *-------------------------------------------------------------------*/
 
 template< class TYPE >
-class LINKS_TO: public LINKSbase
+class LINKS_TO< TYPE, 0 >: public LINKSbase
 {
 public:
 
@@ -568,6 +620,72 @@ public:
     }
 };
 
+/*-------------------------------------------------------------------*
+ | LINKS_TO< TYPE, NUM_INLINE > -- list of links with room for
+ |                                 NUM_INLINE LINK_NODEs inside it
+ *-------------------------------------------------------------------*/
+
+template< class TYPE, int NUM_INLINE >
+class LINKS_TO: public LINKS_TO< TYPE, 0 >
+{
+private:
+
+    LINK_SLOT m_slot[ NUM_INLINE ];
+
+public:
+
+    LINKS_TO(): LINKS_TO< TYPE, 0 >()
+    {
+        clearSlots();
+    }
+    LINKS_TO( const LINKS_TO &links ): LINKS_TO< TYPE, 0 >()
+    {
+        assert( links.isEmpty() );
+        //THROW_ERR( "Trying to copy links (don't know how)" )
+
+        clearSlots();
+    }
+
+    /* the links have to go before the slots they're in do */
+    ~LINKS_TO()
+    {
+        this->removeAll();
+    }
+
+private:
+
+    void clearSlots()
+    {
+        int i;
+
+        for( i = 0; i < NUM_INLINE; i++ )
+        {
+            m_slot[ i ].header.info.isInline = 1;
+            m_slot[ i ].header.info.inUse = 0;
+        }
+    }
+
+protected:
+
+    virtual void *getFreeSlot()
+    {
+        int i;
+
+        for( i = 0; i < NUM_INLINE; i++ )
+            if( ! m_slot[ i ].header.info.inUse )
+            {
+                m_slot[ i ].header.info.inUse = 1;
+                return m_slot[ i ].node;
+            }
+
+        return 0;
+    }
+
+private:
+
+    LINKS_TO &operator=( const LINKS_TO & );
+};
+
 /*-------------------------------------------------------------------*
  | PTR_INTO_LINKS_TO<> -- template for iterator over list of links
  *-------------------------------------------------------------------*/
@@ -213,7 +213,10 @@
  *     0 otherwise.                                                  *
  *                                                                   *
  *   int getLength() const                                           *
- *     Returns the number of objects on the list.                    *
+ *     Returns the number of objects on the list.  The list keeps    *
+ *     count as objects come and go, so this takes constant time.    *
+ *     (If TSTBUG is defined, the count is checked by counting the   *
+ *     objects.)                                                     *
  *                                                                   *
  *   TYPE *getHead() const                                           *
  *     Returns a pointer to the head object.  The list must not be   *
@@ -250,7 +253,8 @@
  *     the end of this list.  This is much faster than appendCopy(), *
  *     but it leaves the given list empty.  The kind of list given   *
  *     must match the kind of list this member function is being     *
- *     used on.                                                      *
+ *     used on.  (Each object has to be told which list it's on now, *
+ *     so this takes time in proportion to the given list's length.) *
  *                                                                   *
  *   void removeHead()                                               *
  *     Removes the head object from the list.  If the list is        *
@@ -626,11 +630,14 @@ private:
 
     DLISTnode *m_prev;
     DLISTnode *m_next;
+    int *m_listLength;               // length of the list this is on
+                                     //   (0 if it isn't on one)
 
 protected:
 
-    DLISTnode(): m_prev( this ), m_next( this ) {}
-    DLISTnode( const DLISTnode & ): m_prev( this ), m_next( this ) {}
+    DLISTnode(): m_prev( this ), m_next( this ), m_listLength( 0 ) {}
+    DLISTnode( const DLISTnode & ):
+        m_prev( this ), m_next( this ), m_listLength( 0 ) {}
 
     virtual ~DLISTnode()
     {
@@ -656,6 +663,7 @@ protected:
         node->m_prev = m_prev;
         node->m_next = this;
         node->m_prev->m_next = node->m_next->m_prev = node;
+        XcountIn( node );
 
         check();
     }
@@ -667,12 +675,19 @@ protected:
         node->m_prev = this;
         node->m_next = m_next;
         node->m_prev->m_next = node->m_next->m_prev = node;
+        XcountIn( node );
 
         check();
     }
 
     void unlink()
     {
+        if( isOnList() && m_listLength != 0 )
+        {
+            (*m_listLength)--;
+        }
+        m_listLength = 0;
+
         m_prev->m_next = m_next;
         m_next->m_prev = m_prev;
 
@@ -682,6 +697,16 @@ protected:
         m_prev = m_next = this;
     }
 
+    /* a node just put next to this one is on the same list */
+    void XcountIn( DLISTnode *node )
+    {
+        node->m_listLength = m_listLength;
+        if( m_listLength != 0 )
+        {
+            (*m_listLength)++;
+        }
+    }
+
     virtual DLISTnode *XmakeCopy() const = 0;
 
 public:
@@ -853,12 +878,17 @@ private:
 
     dummyDLISTnode m_vnode;          // see comments for
     //   dummyDLISTnode, above
+    int m_length;                    // number of objects on the list
 
 protected:
 
-    DLISTbase(): m_vnode() {}
-    DLISTbase( const DLISTbase &dlist ): m_vnode()
+    DLISTbase(): m_vnode(), m_length( 0 )
+    {
+        m_vnode.m_listLength = &m_length;
+    }
+    DLISTbase( const DLISTbase &dlist ): m_vnode(), m_length( 0 )
     {
+        m_vnode.m_listLength = &m_length;
         XappendCopy( dlist );
     }
 
@@ -900,7 +930,15 @@ public:
         return ! isEmpty() && XgetHead() == XgetTail();
     }
 
-    int getLength() const;
+    int getLength() const
+    {
+#ifdef TSTBUG
+        assert( m_length == XcountLength() );
+        //  THROW_ERR( "Dlist has lost count of its length" )
+#endif
+        return m_length;
+    }
+    int XcountLength() const;
 
     void removeHead()
     {
@@ -917,10 +955,12 @@ public:
     void Xreset()
     {
         m_vnode.Xreset();
+        m_length = 0;
     }
     void XcopyLinks( const DLISTbase &src )
     {
         m_vnode.XcopyLinks( src.m_vnode );
+        m_length = src.m_length;
     }
 
     void check() const
@@ -111,6 +111,17 @@
  *                                                                   *
  *       The indentation defaults to 0.                              *
  *                                                                   *
+ *   A fixedMATRIX< numRows, numCols > is a matrix whose size is     *
+ *   known when the program is compiled.  Its entries are kept in    *
+ *   the object itself, so it never allocates any memory, and the    *
+ *   results of operations on it are simply returned by value.  It   *
+ *   has the same operators as a MATRIX, and the member functions    *
+ *   set(), getNumRows(), getNumCols(), getData(), trans() and       *
+ *   print().  inv() and det() are only provided for 2x2 matrices,   *
+ *   which are inverted in closed form.  Products are summed in the  *
+ *   same order as MATRIX products, so the two give the same         *
+ *   results.                                                        *
+ *                                                                   *
  * IMPLEMENTATION NOTES:                                             *
  *                                                                   *
  *   The implementation of matrices in matrix.H and matrix.C is a    *
@@ -201,6 +212,7 @@
 
 class MATRIX;
 class tmpMATRIX;
+template< int NUM_ROWS, int NUM_COLS > class fixedMATRIX;
 
 /*-------------------------------------------------------------------*
  | MATRIX -- basic matrix class
@@ -496,5 +508,206 @@ inline tmpMATRIX operator*( const MATRIX &m,
     return tmp;
 }
 
+/*-------------------------------------------------------------------*
+ | fixedMATRIX -- matrix with a size fixed at compile time
+ *-------------------------------------------------------------------*/
+
+template< int NUM_ROWS, int NUM_COLS >
+class fixedMATRIX
+{
+private:
+
+    double m_data[ NUM_ROWS * NUM_COLS ];
+
+public:
+
+    double &operator()( int row = 0, int col = 0 )
+    {
+#ifdef TSTBUG
+        assert( 0 <= row && row < NUM_ROWS &&
+                0 <= col && col < NUM_COLS );
+        //THROW_ERR( "Matrix index out of bounds" )
+#endif
+
+        return m_data[ row * NUM_COLS + col ];
+    }
+
+    double operator()( int row = 0, int col = 0 ) const
+    {
+#ifdef TSTBUG
+        assert( 0 <= row && row < NUM_ROWS &&
+                0 <= col && col < NUM_COLS );
+        //THROW_ERR( "Matrix index out of bounds" )
 #endif
 
+        return m_data[ row * NUM_COLS + col ];
+    }
+
+    fixedMATRIX &operator=( double val )
+    {
+        int i;
+
+        for( i = 0; i < NUM_ROWS * NUM_COLS; i++ )
+        {
+            m_data[ i ] = val;
+        }
+        return *this;
+    }
+
+    void set( double firstVal, ... )
+    {
+        va_list ap;
+        int i;
+
+        m_data[ 0 ] = firstVal;
+
+        va_start( ap, firstVal );
+        for( i = 1; i < NUM_ROWS * NUM_COLS; i++ )
+        {
+            m_data[ i ] = va_arg( ap, double );
+        }
+        va_end( ap );
+    }
+
+    int getNumRows() const
+    {
+        return NUM_ROWS;
+    }
+    int getNumCols() const
+    {
+        return NUM_COLS;
+    }
+    double *getData()
+    {
+        return m_data;
+    }
+    const double *getData() const
+    {
+        return m_data;
+    }
+
+    fixedMATRIX< NUM_COLS, NUM_ROWS > trans() const
+    {
+        fixedMATRIX< NUM_COLS, NUM_ROWS > tmp;
+        int row, col;
+
+        for( row = 0; row < NUM_ROWS; row++ )
+            for( col = 0; col < NUM_COLS; col++ )
+            {
+                tmp( col, row ) = (*this)( row, col );
+            }
+
+        return tmp;
+    }
+
+    double det() const
+    {
+        static_assert( NUM_ROWS == 2 && NUM_COLS == 2,
+                       "fixedMATRIX::det() is only for 2x2 matrices" );
+
+        return m_data[ 0 ] * m_data[ 3 ] - m_data[ 1 ] * m_data[ 2 ];
+    }
+
+    fixedMATRIX inv() const
+    {
+        static_assert( NUM_ROWS == 2 && NUM_COLS == 2,
+                       "fixedMATRIX::inv() is only for 2x2 matrices" );
+
+        fixedMATRIX tmp;
+        double d = det();
+
+#ifdef TSTBUG
+        assert( d != 0 );
+        //  THROW_ERR( "Trying to invert singular matrix" );
+#endif
+
+        tmp.m_data[ 0 ] = m_data[ 3 ] / d;
+        tmp.m_data[ 1 ] = -m_data[ 1 ] / d;
+        tmp.m_data[ 2 ] = -m_data[ 2 ] / d;
+        tmp.m_data[ 3 ] = m_data[ 0 ] / d;
+
+        return tmp;
+    }
+
+    void print( int numSpaces = 0 ) const
+    {
+        MATRIX tmp( NUM_ROWS, NUM_COLS );
+
+        memcpy( tmp.getData(), m_data, sizeof( m_data ) );
+        tmp.print( numSpaces );
+    }
+};
+
+/*-------------------------------------------------------------------*
+ | Operators for fixedMATRIX
+ *-------------------------------------------------------------------*/
+
+template< int NUM_ROWS, int NUM_COLS >
+inline fixedMATRIX< NUM_ROWS, NUM_COLS >
+operator+( const fixedMATRIX< NUM_ROWS, NUM_COLS > &m0,
+           const fixedMATRIX< NUM_ROWS, NUM_COLS > &m1 )
+{
+    fixedMATRIX< NUM_ROWS, NUM_COLS > tmp;
+    int i;
+
+    for( i = 0; i < NUM_ROWS * NUM_COLS; i++ )
+    {
+        tmp.getData()[ i ] = m0.getData()[ i ] + m1.getData()[ i ];
+    }
+    return tmp;
+}
+
+template< int NUM_ROWS, int NUM_COLS >
+inline fixedMATRIX< NUM_ROWS, NUM_COLS >
+operator-( const fixedMATRIX< NUM_ROWS, NUM_COLS > &m0,
+           const fixedMATRIX< NUM_ROWS, NUM_COLS > &m1 )
+{
+    fixedMATRIX< NUM_ROWS, NUM_COLS > tmp;
+    int i;
+
+    for( i = 0; i < NUM_ROWS * NUM_COLS; i++ )
+    {
+        tmp.getData()[ i ] = m0.getData()[ i ] - m1.getData()[ i ];
+    }
+    return tmp;
+}
+
+template< int NUM_ROWS, int NUM_SHARED, int NUM_COLS >
+inline fixedMATRIX< NUM_ROWS, NUM_COLS >
+operator*( const fixedMATRIX< NUM_ROWS, NUM_SHARED > &m0,
+           const fixedMATRIX< NUM_SHARED, NUM_COLS > &m1 )
+{
+    fixedMATRIX< NUM_ROWS, NUM_COLS > tmp;
+    double sum;
+    int row, col, i;
+
+    for( row = 0; row < NUM_ROWS; row++ )
+        for( col = 0; col < NUM_COLS; col++ )
+        {
+            sum = 0;
+            for( i = 0; i < NUM_SHARED; i++ )
+            {
+                sum += m0( row, i ) * m1( i, col );
+            }
+            tmp( row, col ) = sum;
+        }
+
+    return tmp;
+}
+
+template< int NUM_ROWS, int NUM_COLS >
+inline fixedMATRIX< NUM_ROWS, NUM_COLS >
+operator*( const fixedMATRIX< NUM_ROWS, NUM_COLS > &m,
+           double num )
+{
+    fixedMATRIX< NUM_ROWS, NUM_COLS > tmp;
+    int i;
+
+    for( i = 0; i < NUM_ROWS * NUM_COLS; i++ )
+    {
+        tmp.getData()[ i ] = m.getData()[ i ] * num;
+    }
+    return tmp;
+}
+
+#endif
@@ -89,7 +89,7 @@
  *                                                                   *
  *       When this routine is called, the MODEL object can set up    *
  *       any internal variables it will be using for all the new     *
- *       state estimates.                                            *
+ *       state estimates (but see the note on threads, below).       *
  *                                                                   *
  *     MDL_STATE *getNewState( int i, MDL_STATE *s, MDL_REPORT *r )  *
  *                                                                   *
@@ -137,6 +137,27 @@
  *       there to give you a chance to clean up any stuff done       *
  *       during the calls to beginNewStates() and getNewState().     *
  *                                                                   *
+ *     int getNewStateLogLikelihood( int i, MDL_STATE *s,            *
+ *                                   MDL_REPORT *r,                  *
+ *                                   double *logLikelihood )         *
+ *                                                                   *
+ *       This may be called in place of getNewState() in the above   *
+ *       loop, when both s and r are given.  If getNewState() would  *
+ *       return null, it should return 0.  Otherwise it should put   *
+ *       the log likelihood of the state that getNewState() would    *
+ *       return into *logLikelihood, and return 1.                   *
+ *                                                                   *
+ *       The state itself is only made if the track hypothesis that  *
+ *       holds it survives pruning.  Then getNewState( i, s, r ) is  *
+ *       called on its own, between another beginNewStates( s, r )   *
+ *       and endNewStates(), and it must give the same likelihood.   *
+ *       Most new track hypotheses are pruned in the scan they are   *
+ *       made in, so a MODEL that can find the likelihood without    *
+ *       making the state doesn't make most of them at all.          *
+ *                                                                   *
+ *       By default this returns -1, which means that the MODEL      *
+ *       can't, and getNewState() is called right away instead.      *
+ *                                                                   *
  *     double getEndLogLikelihood( MDL_STATE *s )                    *
  *                                                                   *
  *       This should return the log of the likelihood that a target  *
@@ -159,6 +180,34 @@
  *                                                                   *
  *       This is the opposite of getSkipLogLikelihood().             *
  *                                                                   *
+ *     void validate( MDL_STATE **s, int numStates,                  *
+ *                    MDL_REPORT **r, int numReports,                *
+ *                    std::vector< int > &valid )                    *
+ *                                                                   *
+ *       This is called once in each scan, before any states are     *
+ *       made from reports.  It is given all the active states that  *
+ *       belong to the MODEL, and all the new reports.  For each     *
+ *       state, in order, it should append to valid the indices (in  *
+ *       increasing order) of the reports that might validate to     *
+ *       that state, followed by -1.  A report may be left out if    *
+ *       getNewState() would return null every time it was given     *
+ *       the state and the report.  Only the pairs that are listed   *
+ *       are tried.  By default, every report is listed for every    *
+ *       state.                                                      *
+ *                                                                   *
+ *       Gating a whole batch of pairs at once is much cheaper than  *
+ *       trying them one at a time in getNewState().  A model whose  *
+ *       gates are small can also avoid looking at most of the       *
+ *       pairs at all.                                               *
+ *                                                                   *
+ *   If setNumThreads() has been called on the MDL_MHT, then all of  *
+ *   these except validate() may be called from several threads at   *
+ *   once, for different states.  So a MODEL that keeps anything in  *
+ *   its own member variables between beginNewStates() and           *
+ *   endNewStates() won't work with more than one thread.  The       *
+ *   states it makes come from the MDL_MHT's pool, which is safe to  *
+ *   use from several threads.                                       *
+ *                                                                   *
  *                            MDL_STATE                              *
  *                                                                   *
  *   A MDL_STATE subclass contains a description of a state          *
@@ -368,6 +417,18 @@
  *       state estimate into its MODEL with each report found by     *
  *       measure().                                                  *
  *                                                                   *
+ *   makeDefaultChildren() and makeChildrenFor() don't install the   *
+ *   children they make.  They append them to a list of              *
+ *   MDL_NEW_CHILDs, along with their parents and the REPORTs        *
+ *   they're based on, and measureAndValidate() installs them        *
+ *   afterward.  That way the leaves can be grown in several         *
+ *   threads at once (if setNumThreads() has been called), since     *
+ *   growing one leaf doesn't touch anything that growing another    *
+ *   does.  The leaves are handed out in chunks, and each chunk has  *
+ *   its own list.  The lists are installed in the order of the      *
+ *   chunks, so the trees come out exactly the same no matter how    *
+ *   many threads are used.                                          *
+ *                                                                   *
  * ----------------------------------------------------------------- *
  *                                                                   *
  *             Copyright (c) 1993, NEC Research Institute            *
@@ -401,6 +462,8 @@
 
 #include "mht.h"
 #include <list>			// for std::list<>
+#include <vector>		// for std::vector<>
+#include <atomic>		// for std::atomic<>
 
 /*-------------------------------------------------------------------*
  | Stuff defined in this file
@@ -418,6 +481,7 @@ class MDL_START_T_HYPO;
 class MDL_CONTINUE_T_HYPO;
 class MDL_SKIP_T_HYPO;
 class MDL_END_T_HYPO;
+struct MDL_NEW_CHILD;
 
 /*-------------------------------------------------------------------*
  | MODEL -- base class for target behavior models
@@ -425,11 +489,25 @@ class MDL_END_T_HYPO;
 
 class MODEL
 {
+private:
+
+    SLAB_POOL *m_pool;                   // pool for new MDL_STATEs
+                                         //   (set by MDL_MHT)
+
 public:
 
-    MODEL() {}
+    MODEL(): m_pool( 0 ) {}
     virtual ~MODEL() {}
 
+    SLAB_POOL *getPool() const
+    {
+        return m_pool;
+    }
+    void setPool( SLAB_POOL *pool )
+    {
+        m_pool = pool;
+    }
+
     virtual int beginNewStates( MDL_STATE *, MDL_REPORT * )
     {
         return 0;
@@ -439,6 +517,11 @@ public:
         return 0;
     }
     virtual void endNewStates() {}
+    virtual int getNewStateLogLikelihood( int, MDL_STATE *, MDL_REPORT *,
+                                          double * )
+    {
+        return -1;
+    }
 
     virtual double getEndLogLikelihood( MDL_STATE * )
     {
@@ -456,6 +539,22 @@ public:
     {
         return 0;
     }
+
+    virtual void validate( MDL_STATE **, int numStates,
+                           MDL_REPORT **, int numReports,
+                           std::vector< int > &valid )
+    {
+        int i, j;
+
+        for( i = 0; i < numStates; i++ )
+        {
+            for( j = 0; j < numReports; j++ )
+            {
+                valid.push_back( j );
+            }
+            valid.push_back( -1 );
+        }
+    }
 };
 
 /*-------------------------------------------------------------------*
@@ -486,6 +585,19 @@ protected:
 
 public:
 
+    static void *operator new( size_t size, SLAB_POOL *pool )
+    {
+        return SLAB_POOL::get( pool, size );
+    }
+    static void operator delete( void *block )
+    {
+        SLAB_POOL::put( block );
+    }
+    static void operator delete( void *block, SLAB_POOL * )
+    {
+        SLAB_POOL::put( block );
+    }
+
     MODEL *getMdl() const
     {
         return m_mdl;
@@ -552,6 +664,12 @@ protected:
     virtual void measure(const std::list<REPORT*> &newReports) {}
     virtual void measureAndValidate(const std::list<REPORT*>& newReports);
 
+    void growLeavesInThread( std::atomic< int > *nextChunk,
+                             MDL_REPORT **reports, int numReports,
+                             const int *valid, const int *first,
+                             std::vector< MDL_NEW_CHILD > *children );
+    static void installChildren( std::vector< MDL_NEW_CHILD > &children );
+
     virtual void startTrack( int, int,
                              MDL_STATE *, MDL_REPORT * )
     {
@@ -608,19 +726,36 @@ protected:
 protected:
 
     MDL_T_HYPO( MDL_MHT *mdlMht ): T_HYPO(), m_mdlMht( mdlMht ) {}
-    MDL_T_HYPO( MDL_MHT *mdlMht, MDL_REPORT *report ):
-        T_HYPO( report ),
-        m_mdlMht( mdlMht )
+
+    virtual ~MDL_T_HYPO() {}
+
+    SLAB_POOL *getPool()
     {
+        return m_mdlMht->getPool();
     }
 
-    virtual ~MDL_T_HYPO() {}
+    inline void addChild( std::vector< MDL_NEW_CHILD > &children,
+                          MDL_T_HYPO *child, MDL_REPORT *report = 0 );
 
-    virtual void makeDefaultChildren() {}
-    virtual void makeChildrenFor( MDL_REPORT * ) {}
+    virtual void makeDefaultChildren( std::vector< MDL_NEW_CHILD > & ) {}
+    virtual void makeChildrenFor( MDL_REPORT *,
+                                  std::vector< MDL_NEW_CHILD > & ) {}
 
 public:
 
+    static void *operator new( size_t size, SLAB_POOL *pool )
+    {
+        return SLAB_POOL::get( pool, size );
+    }
+    static void operator delete( void *block )
+    {
+        SLAB_POOL::put( block );
+    }
+    static void operator delete( void *block, SLAB_POOL * )
+    {
+        SLAB_POOL::put( block );
+    }
+
     virtual MDL_STATE *getState()
     {
         return 0;
@@ -647,8 +782,9 @@ protected:
         m_logLikelihood = 0;
     }
 
-    virtual void makeDefaultChildren();
-    virtual void makeChildrenFor( MDL_REPORT *report );
+    virtual void makeDefaultChildren( std::vector< MDL_NEW_CHILD > &children );
+    virtual void makeChildrenFor( MDL_REPORT *report,
+                                  std::vector< MDL_NEW_CHILD > &children );
 
 public:
 
@@ -670,11 +806,6 @@ class MDL_DUMMY_T_HYPO: public MDL_T_HYPO
 
 protected:
 
-    MDL_DUMMY_T_HYPO( MDL_MHT *mdlMht, MDL_REPORT *report ):
-        MDL_T_HYPO( mdlMht, report )
-    {
-    }
-
     MDL_DUMMY_T_HYPO( MDL_MHT *mdlMht, double logLikelihood = 0 ):
         MDL_T_HYPO( mdlMht )
     {
@@ -685,7 +816,7 @@ protected:
 
     virtual ~MDL_DUMMY_T_HYPO() {}
 
-    virtual void makeDefaultChildren();
+    virtual void makeDefaultChildren( std::vector< MDL_NEW_CHILD > &children );
 
 public:
 
@@ -708,7 +839,7 @@ class MDL_FALARM_T_HYPO: public MDL_DUMMY_T_HYPO
 protected:
 
     MDL_FALARM_T_HYPO( MDL_MHT *mdlMht, MDL_REPORT *report ):
-        MDL_DUMMY_T_HYPO( mdlMht, report )
+        MDL_DUMMY_T_HYPO( mdlMht )
     {
         m_endsTrack = 1;
         m_mustVerify = 1;
@@ -744,36 +875,54 @@ class MDL_CONTINUE_T_HYPO: public MDL_T_HYPO
 
 protected:
 
-    MDL_STATE *m_state;                  // state estimate
+    MDL_STATE *m_state;                  // state estimate (0 until
+                                         //   keep(), if the MODEL
+                                         //   puts it off)
+    int m_stateNum;                      // which of the parent's new
+                                         //   states m_state will be
 
 protected:
 
     MDL_CONTINUE_T_HYPO( MDL_MHT *mdlMht ):
         MDL_T_HYPO( mdlMht ),
-        m_state( 0 )
+        m_state( 0 ),
+        m_stateNum( 0 )
     {
     }
 
-    MDL_CONTINUE_T_HYPO( MDL_MHT *mdlMht, MDL_REPORT *report ):
-        MDL_T_HYPO( mdlMht, report ),
-        m_state( 0 )
+    MDL_CONTINUE_T_HYPO( MDL_MHT *mdlMht,
+                         double trackLogLikelihood,
+                         double continueLogLikelihood,
+                         double detectLogLikelihood,
+                         MDL_STATE *state ):
+        MDL_T_HYPO( mdlMht ),
+        m_state( state ),
+        m_stateNum( 0 )
     {
+        m_endsTrack = 0;
+        m_mustVerify = 1;
+        m_logLikelihood = trackLogLikelihood +
+                          continueLogLikelihood +
+                          detectLogLikelihood +
+                          m_state->getLogLikelihood();
     }
 
     MDL_CONTINUE_T_HYPO( MDL_MHT *mdlMht,
                          double trackLogLikelihood,
                          double continueLogLikelihood,
                          double detectLogLikelihood,
-                         MDL_STATE *state, MDL_REPORT *report ):
-        MDL_T_HYPO( mdlMht, report ),
-        m_state( state )
+                         double stateLogLikelihood,
+                         int stateNum ):
+        MDL_T_HYPO( mdlMht ),
+        m_state( 0 ),
+        m_stateNum( stateNum )
     {
         m_endsTrack = 0;
         m_mustVerify = 1;
         m_logLikelihood = trackLogLikelihood +
                           continueLogLikelihood +
                           detectLogLikelihood +
-                          m_state->getLogLikelihood();
+                          stateLogLikelihood;
     }
 
     virtual ~MDL_CONTINUE_T_HYPO()
@@ -781,8 +930,9 @@ protected:
         delete m_state;
     }
 
-    virtual void makeDefaultChildren();
-    virtual void makeChildrenFor( MDL_REPORT *report );
+    virtual void makeDefaultChildren( std::vector< MDL_NEW_CHILD > &children );
+    virtual void makeChildrenFor( MDL_REPORT *report,
+                                  std::vector< MDL_NEW_CHILD > &children );
     virtual void verify()
     {
         m_mdlMht->continueTrack( getTrackStamp(), getTimeStamp(),
@@ -791,6 +941,8 @@ protected:
 
 public:
 
+    virtual void keep();
+
     virtual MDL_STATE *getState()
     {
         return m_state;
@@ -798,7 +950,10 @@ public:
     virtual void print()
     {
         std::cout << "T:"<<getTrackStamp()<<"[";
-        getState()->print();
+        if( m_state != 0 )
+            getState()->print();
+        else
+            std::cout << "(state not made yet)";
         std::cout << " ," ;
         getReport()->print() ;
         std::cout << "](continue:"<<m_logLikelihood<<")";
@@ -817,9 +972,8 @@ class MDL_START_T_HYPO: public MDL_CONTINUE_T_HYPO
 
 protected:
 
-    MDL_START_T_HYPO( MDL_MHT *mdlMht,
-                      MDL_STATE *state, MDL_REPORT *report ):
-        MDL_CONTINUE_T_HYPO( mdlMht, report )
+    MDL_START_T_HYPO( MDL_MHT *mdlMht, MDL_STATE *state ):
+        MDL_CONTINUE_T_HYPO( mdlMht )
     {
         m_state = state;
         m_endsTrack = 0;
@@ -924,4 +1078,27 @@ public:
     }
 };
 
+/*-------------------------------------------------------------------*
+ | MDL_NEW_CHILD -- child made for a leaf, waiting to be installed
+ *-------------------------------------------------------------------*/
+
+struct MDL_NEW_CHILD
+{
+    MDL_T_HYPO *parent;
+    MDL_T_HYPO *child;
+    MDL_REPORT *report;                  // REPORT to link the child
+                                         //   to, or 0
+};
+
+inline void MDL_T_HYPO::addChild( std::vector< MDL_NEW_CHILD > &children,
+                                  MDL_T_HYPO *child, MDL_REPORT *report )
+{
+    MDL_NEW_CHILD newChild;
+
+    newChild.parent = this;
+    newChild.child = child;
+    newChild.report = report;
+    children.push_back( newChild );
+}
+
 #endif
@@ -127,26 +127,25 @@
  *        respond (e.g. by displaying something on the screen).      *
  *        This is done by the T_HYPO's verify() member.              *
  *                                                                   *
- *   The constructors for T_HYPO are protected (so that T_HYPO may   *
- *   only be used as a base class).  They are:                       *
+ *   The constructor for T_HYPO is protected (so that T_HYPO may     *
+ *   only be used as a base class).  It is:                          *
  *                                                                   *
  *     T_HYPO()                                                      *
  *                                                                   *
- *       This makes a T_HYPO that is independent of any REPORT.  For *
- *       example, one representing the possibility that a target     *
- *       is still in existance but wasn't detected.                  *
- *                                                                   *
- *     T_HYPO( REPORT *report )                                      *
- *                                                                   *
- *       This makes a T_HYPO that is based on the given REPORT.  For *
- *       example, one representing the possibility that the reported *
- *       measurement resulted from this target.                      *
+ *       This makes a T_HYPO that isn't yet part of any tree, or     *
+ *       linked to any REPORT.                                       *
  *                                                                   *
  *   The following member functions for T_HYPO's are public:         *
  *                                                                   *
- *     void installChild( T_HYPO *c )                                *
+ *     void installChild( T_HYPO *c, REPORT *r = 0 )                 *
  *                                                                   *
- *       Install c as a child of this T_HYPO on its tree.            *
+ *       Install c as a child of this T_HYPO on its tree.  If r is   *
+ *       given, c is based on that REPORT (for example, c represents *
+ *       the possibility that the reported measurement resulted from *
+ *       this target), and it is linked to it.  A T_HYPO is only     *
+ *       linked to its REPORT when it is installed, so T_HYPOs for   *
+ *       the same REPORT can be made in several threads at once, as  *
+ *       long as they're installed in one.                           *
  *                                                                   *
  *     int endsTrack()                                               *
  *                                                                   *
@@ -205,6 +204,15 @@
  *       m_mustVerify is set to 1.  If m_mustVerify is set to 0, it  *
  *       will NEVER be called for that T_HYPO.  (See below).         *
  *                                                                   *
+ *     virtual void keep()                                           *
+ *                                                                   *
+ *       Called once the T_HYPO has survived the pruning in the scan *
+ *       it was made in, and before any of its ancestors are         *
+ *       verified and removed.  Most new T_HYPOs don't survive, so   *
+ *       anything that is only needed by the ones that do (such as a *
+ *       full state estimate) can be put off until then.  By         *
+ *       default this does nothing.                                  *
+ *                                                                   *
  *   The following protected member fields of a T_HYPO subclass      *
  *   should be set by the constructor:                               *
  *                                                                   *
@@ -273,10 +281,10 @@
  *       REPORTS that have been installed since the end of the last  *
  *       call to scan().  (See installReport(), below.)              *
  *                                                                   *
- *     ptrDLIST_OF< T_HYPO > m_activeTHypoList                       *
+ *     std::vector< T_HYPO * > m_activeTHypoList                     *
  *                                                                   *
- *       This is a doubly-linked list (see "list.H") of all the      *
- *       T_HYPO's that are currently leaves of track trees.          *
+ *       This is an array of all the T_HYPO's that are currently     *
+ *       leaves of track trees.                                      *
  *                                                                   *
  *   The following member functions are protected:                   *
  *                                                                   *
@@ -328,6 +336,14 @@
  *                                                                   *
  *       See the beginning of these comments for a description.      *
  *                                                                   *
+ *     void setNumThreads( int numThreads )                          *
+ *                                                                   *
+ *       Make new G_HYPOs for up to numThreads GROUPs at once (see   *
+ *       IMPLEMENTATION NOTES, below).  The default is 1, which does *
+ *       them one after another in the calling thread.  The results  *
+ *       are the same either way.  A derived class may use the same  *
+ *       number of threads in measureAndValidate() (MDL_MHT does).   *
+ *                                                                   *
  *       The return value is either 1, if there are some active      *
  *       track trees, or 0 if there were no REPORTs for the scan and *
  *       all of the track trees have been removed.                   *
@@ -366,6 +382,8 @@
  *   contain trees that share measurements are merged.  Finally,     *
  *   every GROUP that can be divided up (because some of the trees   *
  *   in them are no longer sharing any measurements) are split.      *
+ *   Only the GROUPs that new measurements connect, or that contain  *
+ *   more than one tree, are looked at; the rest can't have changed. *
  *                                                                   *
  *   In addition to a list of track trees, each GROUP has a list of  *
  *   G_HYPO's (group hypotheses).  Each G_HYPO is a list of leaf     *
@@ -415,6 +433,15 @@
  *   Any internal node that no longer has any children (because they *
  *   were removed) is now removed.                                   *
  *                                                                   *
+ *   Since the GROUPs share no trees and no REPORTs, making new      *
+ *   G_HYPOs for one GROUP (including the N-scanback pruning) never  *
+ *   touches anything in another.  So, if setNumThreads() has been   *
+ *   called, that step is done for several GROUPs at once.  Each     *
+ *   thread has its own ASSIGNMENT_PQUEUE, and takes the next GROUP  *
+ *   that hasn't been started, largest first, so that one huge       *
+ *   GROUP doesn't end up being started last.  Everything before and *
+ *   after this step is still done in one thread.                    *
+ *                                                                   *
  * ----------------------------------------------------------------- *
  *                                                                   *
  *             Copyright (c) 1993, NEC Research Institute            *
@@ -456,8 +483,11 @@
 #include "tree.h"
 #include "links.h"
 #include "vector.h"
+#include "pool.h"
 #include <list>
 #include <queue>
+#include <vector>
+#include <unordered_set>
 
 
 #ifdef DECLARE_MHT
@@ -478,6 +508,7 @@ class G_HYPO;
 class T_TREE;
 class GROUP;
 class MHT;
+class ASSIGNMENT_PQUEUE;
 
 /*-------------------------------------------------------------------*
  | REPORT -- base class for measurement reports
@@ -504,7 +535,7 @@ private:
     //   only one GROUP will contain
     //   trees referring to any given
     //   REPORT)
-    LINKS_TO< T_HYPO > m_tHypoLinks; // links to T_HYPOs that use this
+    LINKS_TO< T_HYPO, 4 > m_tHypoLinks; // links to T_HYPOs that use this
     //   REPORT
 
 public:
@@ -523,7 +554,6 @@ public:
     {
         m_groupId = groupId;
     }
-    void setAllGroupIds( int groupId );
     void checkGroupIds();
     int isInUse()
     {
@@ -567,11 +597,12 @@ protected:
 private:
 
     T_TREE *m_tree;                  // tree that this T_HYPO is on
+    int m_nodeIndex;                 // index into m_tree's node table
     int m_timeStamp;                 // number of calls to MHT::scan()
                                      //   before this T_HYPO was made
-    LINKS_TO< REPORT > m_reportLink; // link to one REPORT
-    LINKS_TO< G_HYPO > m_gHypoLinks; // links to the G_HYPOs that
-                                     //   postulate this T_HYPO
+    LINKS_TO< REPORT, 1 > m_reportLink; // link to one REPORT
+    LINKS_TO< G_HYPO, 2 > m_gHypoLinks; // links to the G_HYPOs that
+                                         //   postulate this T_HYPO
     char m_flag;                     // used in splitting GROUPs
 
 protected:
@@ -585,6 +616,7 @@ protected:
     T_HYPO():
         TREEnode(),
         m_tree( 0 ),
+        m_nodeIndex( -1 ),
         m_timeStamp( 0 ),
         m_reportLink(),
         m_gHypoLinks(),
@@ -595,32 +627,11 @@ protected:
     {
     }
 
-    T_HYPO( REPORT *report ):
-        TREEnode(),
-        m_tree( 0 ),
-        m_timeStamp( 0 ),
-        m_reportLink(),
-        m_gHypoLinks(),
-        m_flag( 0 ),
-        m_logLikelihood( DOUBLE_NOT_READY ),
-        m_endsTrack( 0 ),
-        m_mustVerify( 0 )
-    {
-        MAKE_LINK( this, m_reportLink,
-                   report, m_tHypoLinks );
-    }
-
     virtual ~T_HYPO() {}
 
 public:
 
-    void installChild( T_HYPO *child )
-    {
-        PTR_INTO_iTREE_OF< T_HYPO > p = this;
-
-        p.insertFirstChild( child );
-        child->setStamps( m_tree, m_timeStamp + 1 );
-    }
+    inline void installChild( T_HYPO *child, REPORT *report = 0 );
 
     int endsTrack()
     {
@@ -666,6 +677,7 @@ public:
     {
         assert(false);
     }//THROW_ERR( "Call to T_HYPO::verify()" ) }
+    virtual void keep() {}
 
 private:
 
@@ -678,10 +690,7 @@ private:
     {
         return hasReport() ? getReport()->getRowNum() : -1;
     }
-    int getNumChildren()
-    {
-        return TREEnode::getNumChildren();
-    }
+    inline int getNumChildren();
 
     void setStamps( T_TREE *tree, int timeStamp )
     {
@@ -744,7 +753,7 @@ private:
     //   m_numTHyposUsedInProblem is
     //   more than the length of
     //   m_tHypoLinks
-    LINKS_TO< T_HYPO > m_tHypoLinks; // links to T_HYPOs postulated
+    LINKS_TO< T_HYPO, 4 > m_tHypoLinks; // links to T_HYPOs postulated
 
 public:
 
@@ -798,7 +807,7 @@ public:
         return m_logLikelihood;
     }
 
-    void makeProblem();
+    void makeProblem( ASSIGNMENT_PQUEUE &apqueue );
     void nScanBackPrune( int maxDepth );
     void recomputeLogLikelihood();
 
@@ -806,6 +815,7 @@ public:
     G_HYPO *split( int groupId );
     void merge( G_HYPO *src );
 
+    unsigned long getSignature();
     void setFlags();
     void resetFlags();
     int allFlagsAreSet();
@@ -821,18 +831,67 @@ public:
 
 /*-------------------------------------------------------------------*
  | T_TREE -- track tree
+ |
+ | Besides the intrusive tree of T_HYPOs, each T_TREE keeps a flat
+ | table of its nodes, with the links between them stored as indices
+ | into the table.  The MHT walks its trees through the table (see
+ | LOOP_TTREE(), below), so that a walk stays inside one block of
+ | memory instead of visiting every T_HYPO on the heap.  Removing a
+ | node just clears its entry; once more than half the entries are
+ | clear, the table is compacted back into pre-order.
+ |
+ | The leaves of the tree are also kept on a list of their own,
+ | threaded through the table in pre-order (see LOOP_TTREEleaves()),
+ | and updated as nodes are added and removed.  So finding the leaves
+ | takes time in proportion to their number, not to the size of the
+ | tree.  For the same reason, the tree counts the nodes that must be
+ | verified and the leaves that don't end the track, which is all
+ | removeUnusedTTrees() needs to know.
+ |
+ | Each node also records its level, which is its depth below the
+ | first root the tree ever had, and a jump link to one of its
+ | ancestors.  Levels don't change when a root is removed, so the
+ | depth of a node is just the difference between its level and the
+ | root's, and the jump links let getAncestor() find the ancestor at
+ | any level in a logarithmic number of steps.  This is how
+ | G_HYPO::nScanBackPrune() finds the children of the roots without
+ | walking all the way up the tree.
  *-------------------------------------------------------------------*/
 
 class T_TREE: public DLISTnode
 {
     friend class MHT;
+    friend class T_HYPO;
+    friend class G_HYPO;
 
 protected:
     MEMBERS_FOR_DLISTnode( T_TREE )
 
 private:
 
+    struct T_NODE
+    {
+        T_HYPO *tHypo;                   // 0 once the node is removed
+        int parent;                      // -1 at the top of the tree
+        int firstChild;                  // -1 at a leaf
+        int nextSibling;                 // -1 at the last sibling
+        int numChildren;
+        int prevLeaf;                    // neighbors on the list of
+        int nextLeaf;                    //   leaves (at leaves only)
+        int level;                       // depth below the first root
+                                         //   the tree ever had
+        int jump;                        // an ancestor further up (see
+                                         //   getAncestor())
+    };
+
     iTREE_OF< T_HYPO > m_tree;
+    std::vector< T_NODE > m_node;        // node table
+    int m_firstRoot;                     // -1 if the tree is empty
+    int m_firstLeaf;                     // head of the list of leaves
+    int m_numRemoved;                    // cleared entries in m_node
+    int m_numMustVerify;                 // nodes with m_mustVerify set
+    int m_numOpenLeaves;                 // leaves with m_endsTrack
+                                         //   not set
     int m_id;
     int m_groupId;
 
@@ -841,13 +900,119 @@ private:
     T_TREE( T_HYPO *root, int id, int time ):
         DLISTnode(),
         m_tree(),
+        m_node(),
+        m_firstRoot( -1 ),
+        m_firstLeaf( -1 ),
+        m_numRemoved( 0 ),
+        m_numMustVerify( 0 ),
+        m_numOpenLeaves( 0 ),
         m_id( id ),
         m_groupId( 0 )
     {
         m_tree.insertRoot( root );
         root->setStamps( this, time );
+        addChild( -1, root );
+    }
+
+    int getFirstNode()
+    {
+        return m_firstRoot;
+    }
+    int getPreOrderNext( int node )
+    {
+        if( m_node[ node ].firstChild != -1 )
+        {
+            return m_node[ node ].firstChild;
+        }
+        while( m_node[ node ].nextSibling == -1 )
+        {
+            node = m_node[ node ].parent;
+            if( node == -1 )
+            {
+                return -1;
+            }
+        }
+        return m_node[ node ].nextSibling;
+    }
+    int getFirstLeaf( int node )
+    {
+        while( m_node[ node ].firstChild != -1 )
+        {
+            node = m_node[ node ].firstChild;
+        }
+        return node;
+    }
+    int getPostOrderNext( int node )
+    {
+        if( m_node[ node ].nextSibling == -1 )
+        {
+            return m_node[ node ].parent;
+        }
+        return getFirstLeaf( m_node[ node ].nextSibling );
+    }
+
+    int getFirstLeafOnList()
+    {
+        return m_firstLeaf;
+    }
+    int getNextLeafOnList( int node )
+    {
+        return m_node[ node ].nextLeaf;
+    }
+
+    T_HYPO *getTHypo( int node )
+    {
+        return m_node[ node ].tHypo;
+    }
+    int isLeaf( int node )
+    {
+        return m_node[ node ].firstChild == -1;
+    }
+
+    int getDepth( int node )
+    {
+        return m_node[ node ].level - m_node[ m_firstRoot ].level;
+    }
+    int getAncestor( int node, int level )
+    {
+        while( m_node[ node ].level > level )
+        {
+            if( m_node[ m_node[ node ].jump ].level >= level )
+            {
+                node = m_node[ node ].jump;
+            }
+            else
+            {
+                node = m_node[ node ].parent;
+            }
+        }
+        return node;
+    }
+
+    void addChild( int parent, T_HYPO *child );
+    void setJump( int node );
+    void insertLeaf( int node, int prev, int next );
+    void linkLeaves();
+    void removeSubtree( int node );
+    void removeRoot();
+    /* see MHT::removeUnusedTTrees() */
+    int isInUse()
+    {
+        return m_firstRoot != -1 &&
+               ! m_node[ m_firstRoot ].tHypo->endsTrack() &&
+               (m_numMustVerify > 0 || m_numOpenLeaves > 0);
     }
 
+    void compactIfSparse()
+    {
+        if( m_numRemoved > (int)m_node.size() / 2 )
+        {
+            compact();
+        }
+    }
+    void compact();
+    void check();
+
 public:
 
     iTREE_OF< T_HYPO > *getTree()
@@ -868,12 +1033,37 @@ public:
     }
 };
 
+/*-------------------------------------------------------------------*
+ | Looping macros for the node table of a T_TREE (the nodes are
+ | visited in the same order as with LOOP_TREE() and
+ | LOOP_TREEchildren() on the T_TREE's iTREE_OF< T_HYPO >, and
+ | LOOP_TTREEleaves() visits the leaves in the order that LOOP_TTREE()
+ | would come to them)
+ *-------------------------------------------------------------------*/
+
+#define LOOP_TTREE( node, tTree )                                     \
+  for( node = (tTree)->getFirstNode();                                \
+       node != -1;                                                    \
+       node = (tTree)->getPreOrderNext( node ) )                      \
+
+#define LOOP_TTREEchildren( child, tTree, node )                      \
+  for( child = (tTree)->m_node[ node ].firstChild;                    \
+       child != -1;                                                   \
+       child = (tTree)->m_node[ child ].nextSibling )                 \
+
+#define LOOP_TTREEleaves( leaf, tTree )                               \
+  for( leaf = (tTree)->getFirstLeafOnList();                          \
+       leaf != -1;                                                    \
+       leaf = (tTree)->getNextLeafOnList( leaf ) )                    \
+
 /*-------------------------------------------------------------------*
  | GROUP -- group of trees that share measurements
  *-------------------------------------------------------------------*/
 
 class GROUP: public DLISTnode
 {
+    friend class MHT;
+
 protected:
     MEMBERS_FOR_DLISTnode( GROUP )
 
@@ -906,15 +1096,26 @@ public:
         return ! m_gHypoList.isEmpty() && (*m_gHypoList).isInUse();
     }
 
-    void merge( GROUP *src,
+    void merge( GROUP **src,
+                int numSrcs,
                 double logMinGHypoRatio,
                 int maxGHypos );
-    void splitIfYouMust();
+    GROUP *splitIfYouMust();
     void removeRepeats();
     void clear(int depth);
     void pruneAndHypothesize( int maxDepth,
                               double logMinGHypoRatio,
                               int maxGHypos );
+    void pruneAndHypothesize( int maxDepth,
+                              double logMinGHypoRatio,
+                              int maxGHypos,
+                              ASSIGNMENT_PQUEUE &apqueue );
+    static void pruneAndHypothesize( GROUP **group,
+                                     int numGroups,
+                                     int maxDepth,
+                                     double logMinGHypoRatio,
+                                     int maxGHypos,
+                                     int numThreads );
 
     int getGroupId()
     {
@@ -924,6 +1125,13 @@ public:
     {
         return m_gHypoList.getLength();
     }
+    int getNumTrees()
+    {
+        return m_gHypoList.isEmpty() ? 0 : (*m_gHypoList).getNumTHypos();
+    }
+    int getProblemSize();
+
+    static long getNumAvoidedSolves();
 
     void check();
     virtual void print()
@@ -955,15 +1163,25 @@ protected:
     int m_maxDepth;
     double m_logMinGHypoRatio;
     int m_maxGHypos;
+    int m_numThreads;                // GROUPs to work on at once
+
+    SLAB_POOL m_pool;                // memory for T_HYPOs and states
+                                     //   (declared before the lists
+                                     //   so that it outlives them)
 
     iDLIST_OF< T_TREE > m_tTreeList;
     PTR_INTO_iDLIST_OF< T_TREE > m_nextNewTTree;
     iDLIST_OF< GROUP > m_groupList;
+    int m_nextGroupId;               // next unused group id
+    std::unordered_set< int > m_changedGroupIds; // ids of GROUPs that
+    //   new REPORTs connect
+    std::vector< GROUP * > m_changedGroups; // GROUPs that might have
+    //   to split or merge this scan
     iDLIST_OF< REPORT > m_oldReportList;
 
     int m_dbgStartA;
     iDLIST_OF< REPORT > m_newReportList;
-    ptrDLIST_OF< T_HYPO > m_activeTHypoList;
+    std::vector< T_HYPO * > m_activeTHypoList;
     std::queue<std::list<REPORT*>> m_reportsQueue;
     bool m_isFirstScan;
 
@@ -975,9 +1193,14 @@ protected:
         m_maxDepth( maxDepth ),
         m_logMinGHypoRatio( log( minGHypoRatio ) ),
         m_maxGHypos( maxGHypos ),
+        m_numThreads( 1 ),
+        m_pool(),
         m_tTreeList(),
         m_nextNewTTree( m_tTreeList ),
         m_groupList(),
+        m_nextGroupId( 1 ),
+        m_changedGroupIds(),
+        m_changedGroups(),
         m_oldReportList(),
         m_newReportList(),
         m_activeTHypoList(),
@@ -1005,7 +1228,8 @@ protected:
                                    m_lastTrackIdUsed++,
                                    m_currentTime + timeOffset );
 
-        m_activeTHypoList.append( *rootNode );
+        tree->setGroupId( m_nextGroupId++ );
+        m_activeTHypoList.push_back( rootNode );
         m_tTreeList.append( tree );
         if( ! m_nextNewTTree.isValid() )
         {
@@ -1035,6 +1259,20 @@ public:
     int scan();
     void clear();
 
+    void setNumThreads( int numThreads )
+    {
+        m_numThreads = numThreads < 1 ? 1 : numThreads;
+    }
+    int getNumThreads()
+    {
+        return m_numThreads;
+    }
+
+    SLAB_POOL *getPool()
+    {
+        return &m_pool;
+    }
+
 private:
 
     void importNewReports();
@@ -1093,6 +1331,26 @@ public:
  | classes they come from (results of chicken-and-egg problems).
  *-------------------------------------------------------------------*/
 
+inline void T_HYPO::installChild( T_HYPO *child, REPORT *report )
+{
+    PTR_INTO_iTREE_OF< T_HYPO > p = this;
+
+    if( report != 0 )
+    {
+        MAKE_LINK( child, m_reportLink,
+                   report, m_tHypoLinks );
+    }
+
+    p.insertFirstChild( child );
+    child->setStamps( m_tree, m_timeStamp + 1 );
+    m_tree->addChild( m_nodeIndex, child );
+}
+
+inline int T_HYPO::getNumChildren()
+{
+    return m_tree->m_node[ m_nodeIndex ].numChildren;
+}
+
 inline int T_HYPO::getTrackStamp()
 {
 #ifdef TSTBUG
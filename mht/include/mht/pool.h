@@ -0,0 +1,124 @@
+/*********************************************************************
+ * FILE: pool.H                                                      *
+ *                                                                   *
+ * CONTENTS:                                                         *
+ *                                                                   *
+ *   Declarations for slab pools of small, fixed-size memory blocks. *
+ *   A SLAB_POOL hands out blocks carved from large slabs, and keeps *
+ *   the blocks that are given back on free lists (one per size      *
+ *   class), so that objects which are made and destroyed in great   *
+ *   numbers -- like T_HYPOs and MDL_STATEs -- don't have to go to   *
+ *   the global heap once the pool has grown to its working size.    *
+ *                                                                   *
+ *   SLAB_POOL's have the following member functions:                *
+ *                                                                   *
+ *     SLAB_POOL()                                                   *
+ *       The constructor takes no arguments.  No memory is allocated *
+ *       until the first block is asked for.                         *
+ *                                                                   *
+ *     static void *get( SLAB_POOL *pool, size_t size )              *
+ *       Return a block of at least size bytes, taken from the given *
+ *       pool.  If pool is null, or the block is too big for any of  *
+ *       the pool's size classes, the block comes from the global    *
+ *       heap instead.                                               *
+ *                                                                   *
+ *     static void put( void *block )                                *
+ *       Give back a block obtained from get().  The block remembers *
+ *       which pool it came from (in a small header just before it), *
+ *       so the pool doesn't have to be given.                       *
+ *                                                                   *
+ *     long getNumSlabs()                                            *
+ *       Return the number of slabs the pool has allocated.          *
+ *                                                                   *
+ *   get() and put() may be called from several threads at once.     *
+ *                                                                   *
+ *   All the slabs are freed when the pool is destroyed, so a pool   *
+ *   must outlive every block taken from it.                         *
+ *                                                                   *
+ *   A class can have its objects kept in a pool by declaring        *
+ *                                                                   *
+ *     static void *operator new( size_t size, SLAB_POOL *pool )     *
+ *     {                                                             *
+ *       return SLAB_POOL::get( pool, size );                        *
+ *     }                                                             *
+ *     static void operator delete( void *block )                    *
+ *     {                                                             *
+ *       SLAB_POOL::put( block );                                    *
+ *     }                                                             *
+ *     static void operator delete( void *block, SLAB_POOL * )       *
+ *     {                                                             *
+ *       SLAB_POOL::put( block );                                    *
+ *     }                                                             *
+ *                                                                   *
+ *   and making its objects with new( pool ) CLASS( ... ).  If they  *
+ *   are deleted through pointers to a base class, the base class    *
+ *   must have a virtual destructor.                                 *
+ *                                                                   *
+ *********************************************************************/
+
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+#include <mutex>
+#include <vector>
+
+class SLAB_POOL
+{
+private:
+
+    enum
+    {
+        SIZE_STEP = 16,                  // granularity of size classes
+        NUM_SIZES = 32,                  // number of size classes
+        SLAB_SIZE = 65536                // bytes in each slab
+    };
+
+    /* header at the start of every block (padded so that the block
+       itself stays aligned for doubles) */
+    union BLOCK_HEADER
+    {
+        struct
+        {
+            SLAB_POOL *pool;             // pool the block came from,
+                                         //   or 0 for the global heap
+            int sizeClass;
+        } info;
+        double align[ 2 ];
+    };
+
+    /* free block (the header is kept; the link goes after it) */
+    struct FREE_BLOCK
+    {
+        BLOCK_HEADER header;
+        FREE_BLOCK *next;
+    };
+
+    FREE_BLOCK *m_freeList[ NUM_SIZES ];
+    std::vector< char * > m_slabs;
+    char *m_slabTop;                     // unused part of the newest
+    char *m_slabEnd;                     //   slab
+    std::mutex m_mutex;
+
+public:
+
+    SLAB_POOL();
+    ~SLAB_POOL();
+
+    static void *get( SLAB_POOL *pool, size_t size );
+    static void put( void *block );
+
+    long getNumSlabs()
+    {
+        return (long)m_slabs.size();
+    }
+
+private:
+
+    FREE_BLOCK *carve( int sizeClass );
+
+    SLAB_POOL( const SLAB_POOL & );
+    SLAB_POOL &operator=( const SLAB_POOL & );
+};
+
+#endif
@@ -126,116 +126,342 @@ static void printProblem( ROW_COL_COST *g_rcc, int g_numRCCs,
 static const int IGNORE_THIS = 0x7FFFFFFF;
 static const double PRECISION = 1000000.;
 
+/* list-position labels run from 0 to ORDER_LIMIT - 1; when there is no
+   room for a new label, the smallest aligned block of labels around it
+   whose occupancy is below ORDER_DENSITY ** (number of bits in the
+   block) gets respaced */
+static const int ORDER_BITS = 62;
+static const unsigned long long ORDER_LIMIT = 1ULL << ORDER_BITS;
+static const double ORDER_DENSITY = 4. / 3.;
+
+/* a lower bound has to be this far above the cost limit, relative to
+   the size of the limit, before the pair is left unsolved (so that
+   rounding can't make the caller ask for it anyway) */
+static const double LIMIT_TOLERANCE = 1e-9;
+
 /*-------------------------------------------------------------------*
- | apqSOLUTION::setup() -- common part of all constructors for
- |                         apqSOLUTION's
- |
- | This takes the base solution and the assignment problem as input,
- | and computes a lower bound on the solution cost.
+ | Static global variables
+ *-------------------------------------------------------------------*/
+
+static int g_dualInheritance = 0;    // used by queues that haven't
+//   been given a setting
+static int g_lowerBounds = 0;        // ditto
+
+/*-------------------------------------------------------------------*
+ | SetDualInheritance() -- choose whether ASSIGNMENT_PQUEUE's that
+ |                         haven't been given a setting of their own
+ |                         solve subproblems starting from their
+ |                         parents' duals
  *-------------------------------------------------------------------*/
 
-void apqSOLUTION::setup( void **baseSolutionTag,
-                         ROW_COL_COST *rcc,
-                         double parentCost )
+void SetDualInheritance( int inherit )
 {
+    g_dualInheritance = inherit;
+}
 
-#ifdef NEVER
-    static VECTOR_OF< double > lowestCostForRow;
-    static VECTOR_OF< char > rowIsInProblem;
-    int numRowsInProblem;
-    static VECTOR_OF< double > lowestCostForCol;
-    static VECTOR_OF< char > colIsInProblem;
-    int numColsInProblem;
-    double rowTotal;
-    double colTotal;
-    int row;
-    int col;
+int GetDualInheritance()
+{
+    return g_dualInheritance;
+}
+
+/*-------------------------------------------------------------------*
+ | SetLowerBounds() -- choose whether ASSIGNMENT_PQUEUE's that haven't
+ |                     been given a setting of their own give
+ |                     subproblems lower bounds on their costs
+ *-------------------------------------------------------------------*/
+
+void SetLowerBounds( int useBounds )
+{
+    g_lowerBounds = useBounds;
+}
+
+int GetLowerBounds()
+{
+    return g_lowerBounds;
+}
+
+/*-------------------------------------------------------------------*
+ | isOverLimit() -- see if a lower bound is safely above a cost limit
+ *-------------------------------------------------------------------*/
+
+static int isOverLimit( double cost, double costLimit )
+{
+    return cost - costLimit > LIMIT_TOLERANCE * (1. + fabs( costLimit ));
+}
+
+/*-------------------------------------------------------------------*
+ | apqPROBLEM::apqPROBLEM() -- copy an assignment problem and index
+ |                             its arcs
+ *-------------------------------------------------------------------*/
+
+apqPROBLEM::apqPROBLEM( void *problemTag,
+                        ROW_COL_COST *rcc,
+                        int numRCCs,
+                        int numRows,
+                        int numCols ):
+    m_problemTag( problemTag ),
+    m_rcc( new ROW_COL_COST[ numRCCs ] ),
+    m_numRCCs( numRCCs ),
+    m_numRows( numRows ),
+    m_numCols( numCols ),
+    m_numUsers( 0 ),
+    m_firstArcOfRow( numRows ),
+    m_arcOfRow( numRCCs ),
+    m_firstArcOfCol( numCols ),
+    m_arcOfCol( numRCCs ),
+    m_arcForTag(),
+    m_arcIsExcluded( numRCCs ),
+    m_rowIsFixed( numRows ),
+    m_colIsFixed( numCols )
+{
+    int row, col;
     int i;
-#endif
 
     memcpy( m_rcc, rcc, m_numRCCs * sizeof( *m_rcc ) );
 
-    if( m_baseSolutionSize > 0 )
+    /* count the arcs in each row and column, and turn the counts into
+       the starting position of each row and column in the index (arcs
+       with a row or column of -1 aren't indexed that way, since those
+       rows and columns are never removed) */
+    m_firstArcOfRow.clear();
+    m_firstArcOfCol.clear();
+    for( i = 0; i < m_numRCCs; i++ )
     {
-        m_baseSolutionTag = new void*[ m_baseSolutionSize ];
-        memcpy( m_baseSolutionTag, baseSolutionTag,
-                m_baseSolutionSize * sizeof( *m_baseSolutionTag ) );
+        if( m_rcc[ i ].row >= 0 )
+        {
+            m_firstArcOfRow[ m_rcc[ i ].row + 1 ]++;
+        }
+        if( m_rcc[ i ].col >= 0 )
+        {
+            m_firstArcOfCol[ m_rcc[ i ].col + 1 ]++;
+        }
+    }
+    for( row = 0; row < m_numRows; row++ )
+    {
+        m_firstArcOfRow[ row + 1 ] += m_firstArcOfRow[ row ];
+    }
+    for( col = 0; col < m_numCols; col++ )
+    {
+        m_firstArcOfCol[ col + 1 ] += m_firstArcOfCol[ col ];
     }
 
-#ifdef NEVER
-    lowestCostForRow.resize( m_numRows );
-    rowIsInProblem.resize( m_numRows );
-    rowIsInProblem.clear();
-    numRowsInProblem = 0;
-
-    lowestCostForCol.resize( m_numCols );
-    colIsInProblem.resize( m_numCols );
-    colIsInProblem.clear();
-    numColsInProblem = 0;
+    /* fill in the index, keeping each row's and column's arcs in the
+       order they appear in the problem (this leaves each row's and
+       column's entry in m_firstArcOf... pointing at the next one's
+       arcs, so they're moved up one afterwards) */
+    for( i = 0; i < m_numRCCs; i++ )
+    {
+        if( m_rcc[ i ].row >= 0 )
+        {
+            m_arcOfRow[ m_firstArcOfRow[ m_rcc[ i ].row ]++ ] = i;
+        }
+        if( m_rcc[ i ].col >= 0 )
+        {
+            m_arcOfCol[ m_firstArcOfCol[ m_rcc[ i ].col ]++ ] = i;
+        }
+    }
+    for( row = m_numRows; row > 0; row-- )
+    {
+        m_firstArcOfRow[ row ] = m_firstArcOfRow[ row - 1 ];
+    }
+    m_firstArcOfRow[ 0 ] = 0;
+    for( col = m_numCols; col > 0; col-- )
+    {
+        m_firstArcOfCol[ col ] = m_firstArcOfCol[ col - 1 ];
+    }
+    m_firstArcOfCol[ 0 ] = 0;
 
+    /* tags are supposed to be unique -- if one isn't, its first arc is
+       the one that gets found */
+    m_arcForTag.reserve( m_numRCCs );
     for( i = 0; i < m_numRCCs; i++ )
     {
-        row = m_rcc[ i ].row;
-        if( row >= 0 )
-            if( ! rowIsInProblem[ row ] ||
-                    m_rcc[ i ].cost < lowestCostForRow[ row ] )
-            {
-                rowIsInProblem[ row ] = 1;
-                lowestCostForRow[ row ] = m_rcc[ i ].cost;
-            }
+        m_arcForTag.insert( std::make_pair( m_rcc[ i ].tag, i ) );
+    }
 
-        col = m_rcc[ i ].col;
-        if( col >= 0 )
-            if( ! colIsInProblem[ col ] ||
-                    m_rcc[ i ].cost < lowestCostForCol[ col ] )
-            {
-                colIsInProblem[ col ] = 1;
-                lowestCostForCol[ col ] = m_rcc[ i ].cost;
-            }
+    m_arcIsExcluded.clear();
+    m_rowIsFixed.clear();
+    m_colIsFixed.clear();
+}
+
+/*-------------------------------------------------------------------*
+ | apqPROBLEM::markSubproblem() -- mark the arcs, rows and columns
+ |                                 that aren't in a subproblem
+ |
+ | After this, arcIsInSubproblem() tells whether an arc is in the
+ | subproblem.  The marks must be removed with unmarkSubproblem()
+ | before any other subproblem is marked.
+ *-------------------------------------------------------------------*/
+
+void apqPROBLEM::markSubproblem( const int *excludedArc,
+                                 int numExcludedArcs,
+                                 const int *baseArc,
+                                 int numBaseArcs )
+{
+    int i;
+
+    for( i = 0; i < numExcludedArcs; i++ )
+    {
+        m_arcIsExcluded[ excludedArc[ i ] ] = 1;
     }
 
-    rowTotal = 0;
-    for( row = 0; row < m_numRows; row++ )
-        if( rowIsInProblem[ row ] )
+    for( i = 0; i < numBaseArcs; i++ )
+    {
+        fixArc( baseArc[ i ] );
+    }
+}
+
+/*-------------------------------------------------------------------*
+ | apqPROBLEM::unmarkSubproblem() -- remove the marks made by
+ |                                   markSubproblem() and fixArc()
+ *-------------------------------------------------------------------*/
+
+void apqPROBLEM::unmarkSubproblem( const int *excludedArc,
+                                   int numExcludedArcs,
+                                   const int *baseArc,
+                                   int numBaseArcs )
+{
+    int row, col;
+    int i;
+
+    for( i = 0; i < numExcludedArcs; i++ )
+    {
+        m_arcIsExcluded[ excludedArc[ i ] ] = 0;
+    }
+
+    for( i = 0; i < numBaseArcs; i++ )
+    {
+        m_arcIsExcluded[ baseArc[ i ] ] = 0;
+
+        row = m_rcc[ baseArc[ i ] ].row;
+        col = m_rcc[ baseArc[ i ] ].col;
+        if( row >= 0 )
         {
-            numRowsInProblem++;
-            rowTotal += lowestCostForRow[ row ];
+            m_rowIsFixed[ row ] = 0;
         }
-
-    colTotal = 0;
-    for( col = 0; col < m_numCols; col++ )
-        if( colIsInProblem[ col ] )
+        if( col >= 0 )
         {
-            numColsInProblem++;
-            colTotal += lowestCostForCol[ col ];
+            m_colIsFixed[ col ] = 0;
         }
+    }
+}
 
-    if( numRowsInProblem > numColsInProblem ||
-            (numRowsInProblem == numColsInProblem && rowTotal > colTotal ) )
+/*-------------------------------------------------------------------*
+ | apqPROBLEM::fixArc() -- mark an arc as being in the base solution
+ |
+ | This removes the arc, its row and its column from the marked
+ | subproblem.
+ *-------------------------------------------------------------------*/
+
+void apqPROBLEM::fixArc( int arc )
+{
+    int row = m_rcc[ arc ].row;
+    int col = m_rcc[ arc ].col;
+
+    m_arcIsExcluded[ arc ] = 1;
+    if( row >= 0 )
     {
-        m_cost = m_baseCost + rowTotal;
+        m_rowIsFixed[ row ] = 1;
     }
-    else
+    if( col >= 0 )
     {
-        m_cost = m_baseCost + colTotal;
+        m_colIsFixed[ col ] = 1;
     }
+}
 
-    if( m_cost < parentCost )
-#endif
-        m_cost = parentCost;
+/*-------------------------------------------------------------------*
+ | apqSOLUTION::apqSOLUTION() -- constructors
+ |
+ | The first makes a pair for a subproblem of 'problem' that has been
+ | made by partitioning.  Its excluded arcs are 'excludedArc' plus
+ | 'newExcludedArc'.  Its cost is estimated as 'lowerBound', which is
+ | at least the cost of its parent's solution.  'duals', if not 0, are
+ | the duals of the parent's solution.
+ |
+ | The second makes a pair for a whole problem, with an estimated cost
+ | of -INFINITY.
+ *-------------------------------------------------------------------*/
 
-#ifdef NEVER
-    m_cost = floor( m_cost * PRECISION ) / PRECISION;
-#endif
+apqSOLUTION::apqSOLUTION( apqPROBLEM *problem,
+                          double baseCost,
+                          double lowerBound,
+                          const int *baseArc,
+                          int baseSolutionSize,
+                          const int *excludedArc,
+                          int numExcludedArcs,
+                          int newExcludedArc,
+                          int numRCCs,
+                          apqDUALS *duals ):
+    m_problem( problem ),
+    m_baseCost( baseCost ),
+    m_cost( lowerBound ),
+    m_solutionSize( 0 ),
+    m_solutionTag( 0 ),
+    m_baseSolutionSize( baseSolutionSize ),
+    m_baseArc( new int[ baseSolutionSize ] ),
+    m_excludedArc( new int[ numExcludedArcs + 1 ] ),
+    m_numExcludedArcs( numExcludedArcs + 1 ),
+    m_numRCCs( numRCCs ),
+    m_duals( duals ),
+    m_order( 0 ),
+    m_heapIndex( -1 ),
+    m_problemIndex( -1 )
+{
+    m_problem->m_numUsers++;
+    if( m_duals != 0 )
+    {
+        m_duals->m_numUsers++;
+    }
+
+    if( baseSolutionSize > 0 )
+    {
+        memcpy( m_baseArc, baseArc, baseSolutionSize * sizeof( *m_baseArc ) );
+    }
+    if( numExcludedArcs > 0 )
+    {
+        memcpy( m_excludedArc, excludedArc,
+                numExcludedArcs * sizeof( *m_excludedArc ) );
+    }
+    m_excludedArc[ numExcludedArcs ] = newExcludedArc;
+}
+
+apqSOLUTION::apqSOLUTION( apqPROBLEM *problem ):
+    m_problem( problem ),
+    m_baseCost( 0 ),
+    m_cost( -INFINITY ),
+    m_solutionSize( 0 ),
+    m_solutionTag( 0 ),
+    m_baseSolutionSize( 0 ),
+    m_baseArc( 0 ),
+    m_excludedArc( 0 ),
+    m_numExcludedArcs( 0 ),
+    m_numRCCs( problem->m_numRCCs ),
+    m_duals( 0 ),
+    m_order( 0 ),
+    m_heapIndex( -1 ),
+    m_problemIndex( -1 )
+{
+    m_problem->m_numUsers++;
 }
 
 /*-------------------------------------------------------------------*
  | apqSOLUTION::solve() -- actually solve the problem
+ |
+ | The arcs of the subproblem are collected into 'rcc', in the same
+ | order as in the original problem, and handed to 'solver'.  If
+ | 'inheritDuals' is 1, the shortest-path method is used, starting
+ | from the parent's duals if there are any, and the duals of the
+ | solution are kept for partitioning.
  *-------------------------------------------------------------------*/
 
-void apqSOLUTION::solve( void )
+void apqSOLUTION::solve( ASSIGNMENT_SOLVER &solver,
+                         VECTOR_OF< ROW_COL_COST > &rcc,
+                         VECTOR_OF< void * > &solutionTag,
+                         int inheritDuals )
 {
-    static VECTOR_OF< void * > solutionTag;
+    apqPROBLEM &problem = *m_problem;
+    apqDUALS *duals;
+    int numRCCs;
     int solutionSize;
     int i;
 
@@ -244,19 +470,45 @@ void apqSOLUTION::solve( void )
         return;
     }
 
-    for ( i=0; i<m_numRCCs; i++)
-    {
-        int row = m_rcc[i].row;
-        int col = m_rcc[i].col;
+    rcc.resize( m_numRCCs );
+    numRCCs = 0;
+    problem.markSubproblem( m_excludedArc, m_numExcludedArcs,
+                            m_baseArc, m_baseSolutionSize );
+    for( i = 0; i < problem.m_numRCCs; i++ )
+        if( problem.arcIsInSubproblem( i ) )
+        {
+            rcc[ numRCCs++ ] = problem.m_rcc[ i ];
+        }
+    problem.unmarkSubproblem( m_excludedArc, m_numExcludedArcs,
+                              m_baseArc, m_baseSolutionSize );
 
-#ifdef SDBG
-        printf("before BestAssign  m_rcc=%d row=%d col=%d tag=%d\n",&(m_rcc[i]),row,col,m_rcc[i].tag);
+#ifdef TSTBUG
+    assert( numRCCs == m_numRCCs );
+    //  THROW_ERR( "Subproblem has the wrong number of arcs" )
 #endif
 
+    if( inheritDuals )
+    {
+        duals = new apqDUALS;
+        m_cost = solver.findBestAssignment( &rcc[ 0 ], numRCCs,
+                                            problem.m_numRows,
+                                            problem.m_numCols,
+                                            m_duals == 0 ?
+                                            0 : &m_duals->m_duals,
+                                            duals->m_duals,
+                                            solutionTag, &solutionSize );
+        releaseDuals();
+        m_duals = duals;
+    }
+    else
+    {
+        m_cost = solver.findBestAssignment( &rcc[ 0 ], numRCCs,
+                                            problem.m_numRows,
+                                            problem.m_numCols,
+                                            solutionTag, &solutionSize );
+        releaseDuals();
     }
 
-    m_cost = FindBestAssignment( m_rcc, m_numRCCs, m_numRows, m_numCols,
-                                 solutionTag, &solutionSize );
     if( m_cost == UNSOLVABLE )
     {
         return;
@@ -266,12 +518,9 @@ void apqSOLUTION::solve( void )
     m_solutionSize = m_baseSolutionSize + solutionSize;
     m_solutionTag = new void*[ m_solutionSize ];
 
-    if( m_baseSolutionSize > 0 )
+    for( i = 0; i < m_baseSolutionSize; i++ )
     {
-        memcpy( m_solutionTag, m_baseSolutionTag,
-                m_baseSolutionSize * sizeof( *m_solutionTag ) );
-        delete [] m_baseSolutionTag;
-        m_baseSolutionTag = 0;
+        m_solutionTag[ i ] = problem.m_rcc[ m_baseArc[ i ] ].tag;
     }
 
     for( i = 0; i < solutionSize; i++ )
@@ -281,121 +530,379 @@ void apqSOLUTION::solve( void )
 }
 
 /*-------------------------------------------------------------------*
- | apqSOLUTION::partition() -- partition an assignment problem
+ | apqSOLUTION::orderPartition() -- put the assignments that
+ |                                  partition() will remove in order
+ |                                  of decreasing lower bound on the
+ |                                  cost of doing without them
  |
- | See apqueue.H for a description of the overall algorithm.
+ | Removing <r,c,s> from a solved problem frees row r, whose dual
+ | variable can then be raised by the lowest reduced cost of the
+ | other arcs out of r, and column c, whose dual variable can be
+ | raised by the lowest reduced cost of the other arcs into c (less
+ | what was already added for r, on arcs parallel to <r,c,s>).  The
+ | raised duals are still feasible, so the best solution without
+ | <r,c,s> costs at least that much more.  Rows and columns of -1
+ | aren't nodes, and contribute nothing.
  |
- | Note: this routine is destructive.  After it is executed, the
- | apqSOLUTION has nothing left in its list of possible assignments.
+ | The bounds are returned in 'removalBound', in the new order.
  *-------------------------------------------------------------------*/
 
-void apqSOLUTION::partition()
+struct apqREMOVAL_BOUND
 {
-    void *doomedRCCtag;
-    ROW_COL_COST doomedRCC;
-    char rowIsNotEmpty;
-    char colIsNotEmpty;
-    apqSOLUTION *solution;
+    double bound;                    // lower bound on increase in cost
+    int index;                       // position in the solution
+    void *tag;                       // tag of the assignment
+};
+
+static int compareRemovalBounds( const void *addr0, const void *addr1 )
+{
+#define bound0 (*(apqREMOVAL_BOUND *)addr0)
+#define bound1 (*(apqREMOVAL_BOUND *)addr1)
+
+    if( bound0.bound > bound1.bound )
+    {
+        return -1;
+    }
+    if( bound0.bound < bound1.bound )
+    {
+        return 1;
+    }
+    return bound0.index - bound1.index;
+
+#undef bound0
+#undef bound1
+}
+
+void apqSOLUTION::orderPartition( VECTOR_OF< double > &removalBound )
+{
+    apqPROBLEM &problem = *m_problem;
+    ASSIGNMENT_DUALS &duals = m_duals->m_duals;
+    VECTOR_OF< apqREMOVAL_BOUND > removal;
+    int numRemovals;
+    int doomedArc;
+    int doomedRow;
+    int doomedCol;
+    double rowSlack;
+    double colSlack;
+    double reducedCost;
+    int arc;
     int i, k;
 
-#ifdef SDBG
-    for( i = 0; i < m_numRCCs; i++ )
+    numRemovals = m_solutionSize - m_baseSolutionSize;
+    if( numRemovals == 0 )
     {
-        printf("m_rcc=%d row=%d col=%d tag=%d\n",&m_rcc[i],m_rcc[i].row,m_rcc[i].col,m_rcc[i].tag);
+        return;
     }
-#endif
+    removal.resize( numRemovals - 1 );
+    removalBound.resize( numRemovals - 1 );
 
-    /* loop through all the assignments in the solution (not counting the
-       ones in the base solution) */
+    problem.markSubproblem( m_excludedArc, m_numExcludedArcs,
+                            m_baseArc, m_baseSolutionSize );
 
-    while( m_baseSolutionSize < m_solutionSize )
+    for( k = 0; k < numRemovals; k++ )
     {
-        /* find the ROW_COL_COST structure for this assignment -- this
-           structure is "doomed" to be removed from the assignment
-           problem */
-        doomedRCCtag = m_solutionTag[ m_baseSolutionSize ];
+        removal[ k ].index = k;
+        removal[ k ].tag = m_solutionTag[ m_baseSolutionSize + k ];
 
-#ifdef SDBG
-        printf("m_baseSolnSize=%d doomedRCCtag=%d m_numRCCs=%d\n",m_baseSolutionSize,doomedRCCtag,m_numRCCs);
-#endif
+        doomedArc = problem.findArc( removal[ k ].tag );
+        doomedRow = problem.m_rcc[ doomedArc ].row;
+        doomedCol = problem.m_rcc[ doomedArc ].col;
 
-        for( i = 0; i < m_numRCCs; i++ )
-            if( m_rcc[ i ].tag == doomedRCCtag )
+        rowSlack = 0.;
+        if( doomedRow >= 0 )
+        {
+            rowSlack = INFINITY;
+            for( i = problem.m_firstArcOfRow[ doomedRow ];
+                    i < problem.m_firstArcOfRow[ doomedRow + 1 ];
+                    i++ )
             {
-                break;
+                arc = problem.m_arcOfRow[ i ];
+                if( arc != doomedArc && problem.arcIsInSubproblem( arc ) )
+                {
+                    reducedCost = duals.getReducedCost( problem.m_rcc[ arc ] );
+                    if( reducedCost < rowSlack )
+                    {
+                        rowSlack = reducedCost;
+                    }
+                }
             }
-        /*
-            #ifdef TSTBUG */
-        assert( i < m_numRCCs );
-        //  THROW_ERR( "ASSIGNMENT_PQUEUE looking for non-existant tag" )
-        /*    #endif*/
+        }
 
-#ifdef SDBG
-        printf("doomedRCC was found at i=%d\n",i);
-#endif
+        colSlack = 0.;
+        if( doomedCol >= 0 && rowSlack != INFINITY )
+        {
+            colSlack = INFINITY;
+            for( i = problem.m_firstArcOfCol[ doomedCol ];
+                    i < problem.m_firstArcOfCol[ doomedCol + 1 ];
+                    i++ )
+            {
+                arc = problem.m_arcOfCol[ i ];
+                if( arc != doomedArc && problem.arcIsInSubproblem( arc ) )
+                {
+                    reducedCost = duals.getReducedCost( problem.m_rcc[ arc ] );
+                    if( doomedRow >= 0 &&
+                            problem.m_rcc[ arc ].row == doomedRow )
+                    {
+                        reducedCost -= rowSlack;
+                    }
+                    if( reducedCost < colSlack )
+                    {
+                        colSlack = reducedCost;
+                    }
+                }
+            }
+            if( colSlack < 0. )
+            {
+                colSlack = 0.;
+            }
+        }
+
+        removal[ k ].bound = rowSlack + colSlack;
+    }
+
+    problem.unmarkSubproblem( m_excludedArc, m_numExcludedArcs,
+                              m_baseArc, m_baseSolutionSize );
+
+    qsort( (void *)&removal[ 0 ], numRemovals, sizeof( removal[ 0 ] ),
+           compareRemovalBounds );
 
-        doomedRCC = m_rcc[ i ];
-        /* a row of -1, or a column of -1, should be ignored, since these
-           aren't really nodes */
-        if( doomedRCC.row < 0 )
+    for( k = 0; k < numRemovals; k++ )
+    {
+        m_solutionTag[ m_baseSolutionSize + k ] = removal[ k ].tag;
+        removalBound[ k ] = removal[ k ].bound;
+    }
+}
+
+/*-------------------------------------------------------------------*
+ | apqSOLUTION::lowestPossibleCost() -- find a lower bound on the cost
+ |                                      of solving the marked
+ |                                      subproblem without an arc
+ |
+ | Every row left in the subproblem has to be covered by exactly one
+ | arc, so the cost is at least the total of the cheapest arc out of
+ | each row, plus whatever arcs that leave columns unassigned (row of
+ | -1) might take off it.  Likewise for columns.  The larger total is
+ | returned.
+ *-------------------------------------------------------------------*/
+
+double apqSOLUTION::lowestPossibleCost( int doomedArc )
+{
+    apqPROBLEM &problem = *m_problem;
+    double rowTotal;
+    double colTotal;
+    double lowestCost;
+    double lowestUnassignedCost;
+    int arc;
+    int row, col;
+    int i;
+
+    rowTotal = 0.;
+    colTotal = 0.;
+
+    for( row = 0; row < problem.m_numRows; row++ )
+    {
+        if( problem.m_rowIsFixed[ row ] )
         {
-            doomedRCC.row = IGNORE_THIS;
+            continue;
         }
-        if( doomedRCC.col < 0 )
+
+        lowestCost = INFINITY;
+        lowestUnassignedCost = 0.;
+        for( i = problem.m_firstArcOfRow[ row ];
+                i < problem.m_firstArcOfRow[ row + 1 ];
+                i++ )
         {
-            doomedRCC.col = IGNORE_THIS;
+            arc = problem.m_arcOfRow[ i ];
+            if( arc != doomedArc && problem.arcIsInSubproblem( arc ) )
+            {
+                if( problem.m_rcc[ arc ].cost < lowestCost )
+                {
+                    lowestCost = problem.m_rcc[ arc ].cost;
+                }
+                if( problem.m_rcc[ arc ].col < 0 &&
+                        problem.m_rcc[ arc ].cost < lowestUnassignedCost )
+                {
+                    lowestUnassignedCost = problem.m_rcc[ arc ].cost;
+                }
+            }
         }
 
-        /* remove the doomed ROW_COL_COST from the assignment problem,
-           maintaining the list of ROW_COL_COST's in order */
-        m_numRCCs--;
-        if( i < m_numRCCs )
-            memmove( &m_rcc[ i ], &m_rcc[ i + 1 ],
-                     (m_numRCCs - i) * sizeof( *m_rcc ) );
+        if( lowestCost != INFINITY )
+        {
+            rowTotal += lowestCost;
+        }
+        colTotal += lowestUnassignedCost;
+    }
 
-        /* What we have now is the problem called P' in the header comments
-           for apqueue.H, after <r,c,s> has been removed. */
+    for( col = 0; col < problem.m_numCols; col++ )
+    {
+        if( problem.m_colIsFixed[ col ] )
+        {
+            continue;
+        }
 
-        /* find out if the row and column can possibly be assigned to
-           other things */
-        rowIsNotEmpty = (doomedRCC.row == IGNORE_THIS);
-        colIsNotEmpty = (doomedRCC.col == IGNORE_THIS);
-        for( i = 0; i < m_numRCCs; i++ )
+        lowestCost = INFINITY;
+        lowestUnassignedCost = 0.;
+        for( i = problem.m_firstArcOfCol[ col ];
+                i < problem.m_firstArcOfCol[ col + 1 ];
+                i++ )
         {
-            if( m_rcc[ i ].row == doomedRCC.row )
+            arc = problem.m_arcOfCol[ i ];
+            if( arc != doomedArc && problem.arcIsInSubproblem( arc ) )
+            {
+                if( problem.m_rcc[ arc ].cost < lowestCost )
+                {
+                    lowestCost = problem.m_rcc[ arc ].cost;
+                }
+                if( problem.m_rcc[ arc ].row < 0 &&
+                        problem.m_rcc[ arc ].cost < lowestUnassignedCost )
+                {
+                    lowestUnassignedCost = problem.m_rcc[ arc ].cost;
+                }
+            }
+        }
+
+        if( lowestCost != INFINITY )
+        {
+            colTotal += lowestCost;
+        }
+        rowTotal += lowestUnassignedCost;
+    }
+
+    return rowTotal > colTotal ? rowTotal : colTotal;
+}
+
+/*-------------------------------------------------------------------*
+ | apqSOLUTION::partition() -- partition an assignment problem
+ |
+ | See apqueue.H for a description of the overall algorithm.
+ |
+ | Note: this routine is destructive.  After it is executed, the
+ | apqSOLUTION has nothing left in its list of possible assignments,
+ | and the order of the assignments in its solution may have been
+ | changed (see orderPartition()).
+ *-------------------------------------------------------------------*/
+
+void apqSOLUTION::partition( int useLowerBounds )
+{
+    apqPROBLEM &problem = *m_problem;
+    VECTOR_OF< double > removalBound;
+    int haveRemovalBounds;
+    int numPartitioned;
+    double lowerBound;
+    double bound;
+    int *baseArc;
+    int doomedArc;
+    int doomedRow;
+    int doomedCol;
+    int rowIsNotEmpty;
+    int colIsNotEmpty;
+    int numRemoved;
+    apqSOLUTION *solution;
+    int arc;
+    int i;
+
+    haveRemovalBounds = 0;
+    if( m_duals != 0 && ! m_duals->m_duals.isEmpty() )
+    {
+        orderPartition( removalBound );
+        haveRemovalBounds = 1;
+    }
+    numPartitioned = 0;
+
+    /* the base solution grows by one assignment for each assignment
+       in the solution */
+    baseArc = new int[ m_solutionSize ];
+    if( m_baseSolutionSize > 0 )
+    {
+        memcpy( baseArc, m_baseArc,
+                m_baseSolutionSize * sizeof( *baseArc ) );
+    }
+    delete [] m_baseArc;
+    m_baseArc = baseArc;
+
+    problem.markSubproblem( m_excludedArc, m_numExcludedArcs,
+                            m_baseArc, m_baseSolutionSize );
+
+    /* loop through all the assignments in the solution (not counting the
+       ones in the base solution) */
+
+    while( m_baseSolutionSize < m_solutionSize )
+    {
+        /* find the arc for this assignment -- this arc is "doomed" to be
+           removed from the assignment problem */
+        doomedArc = problem.findArc( m_solutionTag[ m_baseSolutionSize ] );
+        /*
+            #ifdef TSTBUG */
+        assert( doomedArc >= 0 && problem.arcIsInSubproblem( doomedArc ) );
+        //  THROW_ERR( "ASSIGNMENT_PQUEUE looking for non-existant tag" )
+        /*    #endif*/
+
+        doomedRow = problem.m_rcc[ doomedArc ].row;
+        doomedCol = problem.m_rcc[ doomedArc ].col;
+
+        /* find out if the row and column can possibly be assigned to
+           other things (a row of -1, or a column of -1, should be
+           ignored, since these aren't really nodes) */
+        rowIsNotEmpty = (doomedRow < 0);
+        if( ! rowIsNotEmpty )
+            for( i = problem.m_firstArcOfRow[ doomedRow ];
+                    i < problem.m_firstArcOfRow[ doomedRow + 1 ];
+                    i++ )
             {
-                rowIsNotEmpty = 1;
-                if( colIsNotEmpty )
+                arc = problem.m_arcOfRow[ i ];
+                if( arc != doomedArc && problem.arcIsInSubproblem( arc ) )
                 {
+                    rowIsNotEmpty = 1;
                     break;
                 }
             }
-            if( m_rcc[ i ].col == doomedRCC.col )
+
+        colIsNotEmpty = (doomedCol < 0);
+        if( ! colIsNotEmpty )
+            for( i = problem.m_firstArcOfCol[ doomedCol ];
+                    i < problem.m_firstArcOfCol[ doomedCol + 1 ];
+                    i++ )
             {
-                colIsNotEmpty = 1;
-                if( rowIsNotEmpty )
+                arc = problem.m_arcOfCol[ i ];
+                if( arc != doomedArc && problem.arcIsInSubproblem( arc ) )
                 {
+                    colIsNotEmpty = 1;
                     break;
                 }
             }
-        }
 
-        /* if they can, then proceed find a lower limit on the cost of
-           the best solution to this problem, make a problem/solution pair,
-           and place it on the list */
+        /* if they can, then make a problem/solution pair for the problem
+           called P' in the header comments for apqueue.H (this problem
+           with the doomed arc removed), and place it on the list */
         if( rowIsNotEmpty && colIsNotEmpty )
         {
-            /* the constructor both finds a lower limit on the cost of the
-               best solution and makes the problem/solution pair */
-            solution = new apqSOLUTION( m_problemTag,
+            /* its cost is at least the cost of this pair's solution
+               (and maybe more, see the header comments for apqueue.H) */
+            lowerBound = m_cost;
+            if( useLowerBounds )
+            {
+                if( haveRemovalBounds )
+                {
+                    lowerBound += removalBound[ numPartitioned ];
+                }
+                bound = m_baseCost + lowestPossibleCost( doomedArc );
+                if( bound > lowerBound )
+                {
+                    lowerBound = bound;
+                }
+            }
+
+            solution = new apqSOLUTION( m_problem,
                                         m_baseCost,
-                                        m_cost,
-                                        m_solutionTag,
+                                        lowerBound,
+                                        m_baseArc,
                                         m_baseSolutionSize,
-                                        m_rcc,
-                                        m_numRCCs,
-                                        m_numRows,
-                                        m_numCols );
+                                        m_excludedArc,
+                                        m_numExcludedArcs,
+                                        doomedArc,
+                                        m_numRCCs - 1,
+                                        m_duals );
 
             /* the pair is invalid if no solution is possible */
             if( solution->isValid() )
@@ -408,43 +915,44 @@ void apqSOLUTION::partition()
             }
         }
 
-        /* remove all the possible assignments for this row and column */
-        if( (rowIsNotEmpty && doomedRCC.row != IGNORE_THIS) ||
-                (colIsNotEmpty && doomedRCC.col != IGNORE_THIS) )
-        {
-            for( i = 0;
-                    i < m_numRCCs &&
-                    m_rcc[ i ].row != doomedRCC.row &&
-                    m_rcc[ i ].col != doomedRCC.col;
+        /* count the possible assignments for this row and column, which
+           are about to be removed along with the doomed arc */
+        numRemoved = 0;
+        if( doomedRow >= 0 )
+            for( i = problem.m_firstArcOfRow[ doomedRow ];
+                    i < problem.m_firstArcOfRow[ doomedRow + 1 ];
+                    i++ )
+                if( problem.arcIsInSubproblem( problem.m_arcOfRow[ i ] ) )
+                {
+                    numRemoved++;
+                }
+        if( doomedCol >= 0 )
+            for( i = problem.m_firstArcOfCol[ doomedCol ];
+                    i < problem.m_firstArcOfCol[ doomedCol + 1 ];
                     i++ )
-                ;
-
-            k = i;
-            while( i < m_numRCCs )
             {
-                if( m_rcc[ i ].row != doomedRCC.row &&
-                        m_rcc[ i ].col != doomedRCC.col )
+                arc = problem.m_arcOfCol[ i ];
+                if( (doomedRow < 0 || problem.m_rcc[ arc ].row != doomedRow) &&
+                        problem.arcIsInSubproblem( arc ) )
                 {
-                    m_rcc[ k++ ] = m_rcc[ i ];
+                    numRemoved++;
                 }
-                i++;
             }
-
-            m_numRCCs = k;
-        }
-
-        /* add the "doomed" assignment to the base solution */
-        m_baseCost += doomedRCC.cost;
-        m_baseSolutionSize++;
-
-#ifdef SDBG
-        for( i = 0; i < m_numRCCs; i++ )
+        if( doomedRow < 0 && doomedCol < 0 )
         {
-            printf("m_rcc=%d row=%d col=%d tag=%d\n",&m_rcc[i],m_rcc[i].row,m_rcc[i].col,m_rcc[i].tag);
+            numRemoved++;
         }
-#endif
+        m_numRCCs -= numRemoved;
 
+        /* add the "doomed" assignment to the base solution */
+        problem.fixArc( doomedArc );
+        m_baseCost += problem.m_rcc[ doomedArc ].cost;
+        m_baseArc[ m_baseSolutionSize++ ] = doomedArc;
+        numPartitioned++;
     }
+
+    problem.unmarkSubproblem( m_excludedArc, m_numExcludedArcs,
+                              m_baseArc, m_baseSolutionSize );
 }
 
 /*-------------------------------------------------------------------*
@@ -466,12 +974,41 @@ getSolutionTags( VECTOR_OF< void * > &solutionTag, int *solutionSize )
 
 }
 
+/*-------------------------------------------------------------------*
+ | apqSOLUTION::isBetterThan() -- find out whether this
+ |                                problem/solution pair should be
+ |                                returned before another one
+ |
+ | Lower costs come first.  Among pairs with equal costs, solved
+ | pairs come before unsolved ones, then pairs with fewer possible
+ | assignments come first, and finally pairs nearer the head of the
+ | list come first.
+ *-------------------------------------------------------------------*/
+
+int apqSOLUTION::isBetterThan( const apqSOLUTION &other ) const
+{
+    if( m_cost != other.m_cost )
+    {
+        return m_cost < other.m_cost;
+    }
+    if( isSolved() != other.isSolved() )
+    {
+        return isSolved();
+    }
+    if( m_numRCCs != other.m_numRCCs )
+    {
+        return m_numRCCs < other.m_numRCCs;
+    }
+    return m_order < other.m_order;
+}
+
 /*-------------------------------------------------------------------*
  | apqSOLUTION::print() -- for debugging
  *-------------------------------------------------------------------*/
 
 void apqSOLUTION::print()
 {
+    apqPROBLEM &problem = *m_problem;
     int i, j;
     ROW_COL_COST *rcc;
 
@@ -497,18 +1034,50 @@ void apqSOLUTION::print()
                       << rcc->cost << ")";
     }
 
-    for( i = 0; i < m_numRCCs; i++ )
+    problem.markSubproblem( m_excludedArc, m_numExcludedArcs,
+                            m_baseArc, m_baseSolutionSize );
+    for( i = 0; i < problem.m_numRCCs; i++ )
     {
+        if( ! problem.arcIsInSubproblem( i ) )
+        {
+            continue;
+        }
+        rcc = &problem.m_rcc[ i ];
         for( j = 0; j < m_solutionSize; j++ )
-            if( m_solutionTag[ j ] == m_rcc[ i ].tag )
+            if( m_solutionTag[ j ] == rcc->tag )
             {
                 break;
             }
         if( j >= m_solutionSize )
-            std::cout << "  " << m_rcc[ i ].row << ","
-                      << m_rcc[ i ].col << ","
-                      << m_rcc[ i ].cost << " ";
+            std::cout << "  " << rcc->row << ","
+                      << rcc->col << ","
+                      << rcc->cost << " ";
     }
+    problem.unmarkSubproblem( m_excludedArc, m_numExcludedArcs,
+                              m_baseArc, m_baseSolutionSize );
+}
+
+/*-------------------------------------------------------------------*
+ | ASSIGNMENT_PQUEUE::getDualInheritance() -- find out whether
+ |                                            subproblems are solved
+ |                                            starting from their
+ |                                            parents' duals
+ *-------------------------------------------------------------------*/
+
+int ASSIGNMENT_PQUEUE::getDualInheritance() const
+{
+    return m_dualInheritanceIsSet ? m_dualInheritance : g_dualInheritance;
+}
+
+/*-------------------------------------------------------------------*
+ | ASSIGNMENT_PQUEUE::getLowerBounds() -- find out whether subproblems
+ |                                        get lower bounds on their
+ |                                        costs
+ *-------------------------------------------------------------------*/
+
+int ASSIGNMENT_PQUEUE::getLowerBounds() const
+{
+    return m_lowerBoundsAreSet ? m_lowerBounds : g_lowerBounds;
 }
 
 /*-------------------------------------------------------------------*
@@ -522,14 +1091,15 @@ void ASSIGNMENT_PQUEUE::addProblem( void *problemTag,
                                     int numRows,
                                     int numCols )
 {
-    apqSOLUTION *solution = new apqSOLUTION( problemTag,
-            rcc,
-            numRCCs,
-            numRows,
-            numCols );
+    apqSOLUTION *solution = new apqSOLUTION( new apqPROBLEM( problemTag,
+                                                             rcc,
+                                                             numRCCs,
+                                                             numRows,
+                                                             numCols ) );
     if( solution->isValid() )
     {
         m_solutionList.prepend( solution );
+        insertSolutions( solution, 1 );
     }
     else
     {
@@ -544,12 +1114,63 @@ void ASSIGNMENT_PQUEUE::addProblem( void *problemTag,
 
 void ASSIGNMENT_PQUEUE::removeProblem( void *problemTag )
 {
-    PTR_INTO_iDLIST_OF< apqSOLUTION > ptr;
+    std::unordered_map< void *, std::vector< apqSOLUTION * > >::iterator
+    entry;
+    apqSOLUTION *solution;
+    int i;
+
+    entry = m_problemIndex.find( problemTag );
+    if( entry == m_problemIndex.end() )
+    {
+        return;
+    }
 
-    LOOP_DLIST( ptr, m_solutionList )
-    if( (*ptr).getProblemTag() == problemTag )
+    for( i = 0; i < (int)entry->second.size(); i++ )
     {
-        ptr.remove();
+        solution = entry->second[ i ];
+        countAvoidedSolve( solution );
+        heapRemove( solution );
+        delete solution;
+    }
+
+    m_problemIndex.erase( entry );
+}
+
+/*-------------------------------------------------------------------*
+ | ASSIGNMENT_PQUEUE::removeAllProblems() -- empty the queue
+ |
+ | This also removes the cost limit.
+ *-------------------------------------------------------------------*/
+
+void ASSIGNMENT_PQUEUE::removeAllProblems()
+{
+    int i;
+
+    for( i = 0; i < (int)m_heap.size(); i++ )
+    {
+        countAvoidedSolve( m_heap[ i ] );
+    }
+
+    m_solutionList.removeAll();
+    m_heap.clear();
+    m_problemIndex.clear();
+    m_bestSolution = 0;
+    m_costLimit = INFINITY;
+}
+
+/*-------------------------------------------------------------------*
+ | ASSIGNMENT_PQUEUE::countAvoidedSolve() -- count a pair that is
+ |                                           being thrown away, if
+ |                                           the cost limit kept it
+ |                                           from being solved
+ *-------------------------------------------------------------------*/
+
+void ASSIGNMENT_PQUEUE::countAvoidedSolve( apqSOLUTION *solution )
+{
+    if( ! solution->isSolved() &&
+            isOverLimit( solution->getCost(), m_costLimit ) )
+    {
+        m_numAvoidedSolves++;
     }
 }
 
@@ -562,8 +1183,12 @@ void *ASSIGNMENT_PQUEUE::
 getNextSolution( VECTOR_OF< void * > &solutionTag, int *solutionSize )
 {
     void *problemTag;
+    DLISTnode *nextOnList;
+    apqSOLUTION *firstChild;
+    apqSOLUTION *child;
+    int numChildren;
 
-    findBestSolution();
+    findBestSolution( INFINITY );
     if( m_bestSolution == 0 )
     {
         return 0;
@@ -572,10 +1197,34 @@ getNextSolution( VECTOR_OF< void * > &solutionTag, int *solutionSize )
     problemTag = m_bestSolution->getProblemTag();
     m_bestSolution->getSolutionTags( solutionTag, solutionSize );
 
-    m_bestSolution->partition();
-    delete m_bestSolution;
+    /* partitioning puts the new pairs on the list right after the one
+       being partitioned, so they're everything between it and the
+       node that used to follow it */
+    nextOnList = m_bestSolution->XgetNext();
+    m_bestSolution->partition( getLowerBounds() );
+
+    firstChild = 0;
+    numChildren = 0;
+    if( m_bestSolution->XgetNext() != nextOnList )
+    {
+        firstChild = (apqSOLUTION *)m_bestSolution->XgetNext();
+        numChildren = 1;
+        for( child = firstChild;
+                child->XgetNext() != nextOnList;
+                child = (apqSOLUTION *)child->XgetNext() )
+        {
+            numChildren++;
+        }
+    }
+
+    removeSolution( m_bestSolution );
     m_bestSolution = 0;
 
+    if( numChildren > 0 )
+    {
+        insertSolutions( firstChild, numChildren );
+    }
+
     return problemTag;
 }
 
@@ -583,47 +1232,37 @@ getNextSolution( VECTOR_OF< void * > &solutionTag, int *solutionSize )
  | ASSIGNMENT_PQUEUE::findBestSolution() -- find the best solution on
  |                                          the list of
  |                                          problem/solution pairs
+ |
+ | If the best pair hasn't been solved, and its lower bound is above
+ | 'costLimit', it is left unsolved, and m_bestSolution is set to it
+ | anyway.
  *-------------------------------------------------------------------*/
 
-void ASSIGNMENT_PQUEUE::findBestSolution()
+void ASSIGNMENT_PQUEUE::findBestSolution( double costLimit )
 {
-    PTR_INTO_iDLIST_OF< apqSOLUTION > ptr;
     double estimatedCost;
 
     m_bestSolution = 0;
 
     while( m_bestSolution == 0 )
     {
-        if( m_solutionList.isEmpty() )
+        if( m_heap.empty() )
         {
             return;
         }
 
-        m_bestSolution = m_solutionList.getHead();
-        LOOP_DLIST( ptr, m_solutionList )
+        m_bestSolution = m_heap[ 0 ];
+
+        if( ! m_bestSolution->isSolved() )
         {
-            if( (*ptr).getCost() < m_bestSolution->getCost() )
+            if( isOverLimit( m_bestSolution->getCost(), costLimit ) )
             {
-                m_bestSolution = ptr.get();
+                return;
             }
-            else if( (*ptr).getCost() == m_bestSolution->getCost() )
-                if( (*ptr).isSolved() == m_bestSolution->isSolved() )
-                {
-                    if( (*ptr).getNumRCCs() < m_bestSolution->getNumRCCs() )
-                    {
-                        m_bestSolution = ptr.get();
-                    }
-                }
-                else if( (*ptr).isSolved() )
-                {
-                    m_bestSolution = ptr.get();
-                }
-        }
 
-        if( ! m_bestSolution->isSolved() )
-        {
             estimatedCost = m_bestSolution->getCost();
-            m_bestSolution->solve();
+            m_bestSolution->solve( m_solver, m_rcc, m_solutionTag,
+                                   getDualInheritance() );
             /*
                   #ifdef TSTBUG
             */
@@ -637,14 +1276,292 @@ void ASSIGNMENT_PQUEUE::findBestSolution()
 
             if( m_bestSolution->getCost() == UNSOLVABLE )
             {
-                delete m_bestSolution;
+                removeSolution( m_bestSolution );
                 m_bestSolution = 0;
             }
-            else if( m_bestSolution->getCost() > estimatedCost )
+            else
             {
-                m_bestSolution = 0;
+                heapDown( m_bestSolution->m_heapIndex );
+                if( m_bestSolution->getCost() > estimatedCost )
+                {
+                    m_bestSolution = 0;
+                }
             }
         }
     }
 }
 
+/*-------------------------------------------------------------------*
+ | ASSIGNMENT_PQUEUE::insertSolutions() -- enter problem/solution
+ |                                         pairs into the heap and
+ |                                         the problem index
+ |
+ | The pairs must already be on m_solutionList, as a run of 'count'
+ | nodes starting with 'first'.
+ *-------------------------------------------------------------------*/
+
+void ASSIGNMENT_PQUEUE::insertSolutions( apqSOLUTION *first, int count )
+{
+    std::vector< apqSOLUTION * > *problemSolutions;
+    apqSOLUTION *solution;
+    int i;
+
+    placeInOrder( first, count );
+
+    solution = first;
+    for( i = 0; i < count; i++ )
+    {
+        if( i > 0 )
+        {
+            solution = (apqSOLUTION *)solution->XgetNext();
+        }
+
+        m_heap.push_back( solution );
+        heapSet( (int)m_heap.size() - 1, solution );
+        heapUp( solution->m_heapIndex );
+
+        problemSolutions = &m_problemIndex[ solution->getProblemTag() ];
+        solution->m_problemIndex = (int)problemSolutions->size();
+        problemSolutions->push_back( solution );
+    }
+}
+
+/*-------------------------------------------------------------------*
+ | ASSIGNMENT_PQUEUE::removeSolution() -- remove one problem/solution
+ |                                        pair from the list, the
+ |                                        heap and the problem index,
+ |                                        and delete it
+ *-------------------------------------------------------------------*/
+
+void ASSIGNMENT_PQUEUE::removeSolution( apqSOLUTION *solution )
+{
+    std::vector< apqSOLUTION * > &problemSolutions =
+        m_problemIndex[ solution->getProblemTag() ];
+    apqSOLUTION *moved;
+
+    heapRemove( solution );
+
+    moved = problemSolutions.back();
+    problemSolutions[ solution->m_problemIndex ] = moved;
+    moved->m_problemIndex = solution->m_problemIndex;
+    problemSolutions.pop_back();
+    if( problemSolutions.empty() )
+    {
+        m_problemIndex.erase( solution->getProblemTag() );
+    }
+
+    delete solution;
+}
+
+/*-------------------------------------------------------------------*
+ | ASSIGNMENT_PQUEUE::placeInOrder() -- give list-position labels to
+ |                                      a run of new nodes on
+ |                                      m_solutionList
+ |
+ | The labels are spread evenly over the gap between the labels of
+ | the nodes on either side of the run.  If the gap is too small, the
+ | labels around it are respaced.
+ *-------------------------------------------------------------------*/
+
+void ASSIGNMENT_PQUEUE::placeInOrder( apqSOLUTION *first, int count )
+{
+    apqSOLUTION *solution;
+    unsigned long long low;
+    unsigned long long high;
+    unsigned long long step;
+    int i;
+
+    solution = first;
+    for( i = 1; i < count; i++ )
+    {
+        solution = (apqSOLUTION *)solution->XgetNext();
+    }
+
+    low = first->isHead() ?
+          0 :
+          ((apqSOLUTION *)first->XgetPrev())->m_order + 1;
+    high = solution->isTail() ?
+           ORDER_LIMIT :
+           ((apqSOLUTION *)solution->XgetNext())->m_order;
+
+    step = (high - low) / (count + 1);
+    if( step == 0 )
+    {
+        spaceOrderAround( first, count );
+        return;
+    }
+
+    solution = first;
+    for( i = 1; i <= count; i++ )
+    {
+        if( i > 1 )
+        {
+            solution = (apqSOLUTION *)solution->XgetNext();
+        }
+        solution->m_order = low + i * step - 1;
+    }
+}
+
+/*-------------------------------------------------------------------*
+ | ASSIGNMENT_PQUEUE::spaceOrderAround() -- respace the list-position
+ |                                          labels around a run of
+ |                                          new nodes
+ |
+ | This looks at successively larger aligned blocks of labels around
+ | the place where the run goes, until it finds one that isn't too
+ | crowded, and then spreads the labels in that block (and the new
+ | ones) evenly across it.  Since the blocks are allowed to get more
+ | crowded as they get bigger, this takes O(log^2 n) amortized time
+ | per label.
+ *-------------------------------------------------------------------*/
+
+void ASSIGNMENT_PQUEUE::spaceOrderAround( apqSOLUTION *first, int count )
+{
+    apqSOLUTION *lowest;
+    apqSOLUTION *highest;
+    apqSOLUTION *solution;
+    unsigned long long anchor;
+    unsigned long long base;
+    unsigned long long size;
+    unsigned long long step;
+    double maxInBlock;
+    int numInBlock;
+    int numBits;
+    int i;
+
+    lowest = first;
+    highest = first;
+    for( i = 1; i < count; i++ )
+    {
+        highest = (apqSOLUTION *)highest->XgetNext();
+    }
+    numInBlock = count;
+
+    anchor = first->isHead() ?
+             0 :
+             ((apqSOLUTION *)first->XgetPrev())->m_order;
+
+    maxInBlock = 1;
+    for( numBits = 1; ; numBits++ )
+    {
+        maxInBlock *= ORDER_DENSITY;
+        size = 1ULL << numBits;
+        base = anchor & ~(size - 1);
+
+        while( ! lowest->isHead() &&
+                ((apqSOLUTION *)lowest->XgetPrev())->m_order >= base )
+        {
+            lowest = (apqSOLUTION *)lowest->XgetPrev();
+            numInBlock++;
+        }
+        while( ! highest->isTail() &&
+                ((apqSOLUTION *)highest->XgetNext())->m_order < base + size )
+        {
+            highest = (apqSOLUTION *)highest->XgetNext();
+            numInBlock++;
+        }
+
+        if( numInBlock < maxInBlock || numBits == ORDER_BITS )
+        {
+            break;
+        }
+    }
+
+    step = size / numInBlock;
+
+#ifdef TSTBUG
+    assert( step > 0 );
+    //  THROW_ERR( "Ran out of list-position labels" )
+#endif
+
+    solution = lowest;
+    for( i = 0; i < numInBlock; i++ )
+    {
+        if( i > 0 )
+        {
+            solution = (apqSOLUTION *)solution->XgetNext();
+        }
+        solution->m_order = base + i * step;
+    }
+}
+
+/*-------------------------------------------------------------------*
+ | ASSIGNMENT_PQUEUE::heapRemove() -- take a problem/solution pair
+ |                                    out of the heap
+ *-------------------------------------------------------------------*/
+
+void ASSIGNMENT_PQUEUE::heapRemove( apqSOLUTION *solution )
+{
+    apqSOLUTION *last;
+    int index;
+
+    index = solution->m_heapIndex;
+    last = m_heap.back();
+    m_heap.pop_back();
+    solution->m_heapIndex = -1;
+
+    if( last != solution )
+    {
+        heapSet( index, last );
+        heapUp( index );
+        heapDown( last->m_heapIndex );
+    }
+}
+
+/*-------------------------------------------------------------------*
+ | ASSIGNMENT_PQUEUE::heapUp() -- move a pair towards the top of the
+ |                                heap until it's in order
+ *-------------------------------------------------------------------*/
+
+void ASSIGNMENT_PQUEUE::heapUp( int index )
+{
+    apqSOLUTION *solution = m_heap[ index ];
+    int parent;
+
+    while( index > 0 )
+    {
+        parent = (index - 1) / 2;
+        if( ! solution->isBetterThan( *m_heap[ parent ] ) )
+        {
+            break;
+        }
+        heapSet( index, m_heap[ parent ] );
+        index = parent;
+    }
+
+    heapSet( index, solution );
+}
+
+/*-------------------------------------------------------------------*
+ | ASSIGNMENT_PQUEUE::heapDown() -- move a pair towards the bottom of
+ |                                  the heap until it's in order
+ *-------------------------------------------------------------------*/
+
+void ASSIGNMENT_PQUEUE::heapDown( int index )
+{
+    apqSOLUTION *solution = m_heap[ index ];
+    int heapSize = (int)m_heap.size();
+    int child;
+
+    for( ;; )
+    {
+        child = 2 * index + 1;
+        if( child >= heapSize )
+        {
+            break;
+        }
+        if( child + 1 < heapSize &&
+                m_heap[ child + 1 ]->isBetterThan( *m_heap[ child ] ) )
+        {
+            child++;
+        }
+        if( ! m_heap[ child ]->isBetterThan( *solution ) )
+        {
+            break;
+        }
+        heapSet( index, m_heap[ child ] );
+        index = child;
+    }
+
+    heapSet( index, solution );
+}
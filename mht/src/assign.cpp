@@ -25,12 +25,13 @@
  *   (they didn't make big enough differences to warrant the added   *
  *   complexity).                                                    *
  *                                                                   *
- *   Problems are solved by FindBestAssignment().  This begins by    *
- *   calling setupProblem(), which initializes a bunch of static     *
- *   globals to describe the problem in a way that can be solved by  *
- *   the Hungarian method.  There are two changes that               *
- *   setupProblem() must make to the original representation of the  *
- *   problem:                                                        *
+ *   Problems are solved by ASSIGNMENT_SOLVER::findBestAssignment()  *
+ *   (FindBestAssignment() just calls it for a shared solver).  This *
+ *   begins by calling setupProblem(), which initializes the         *
+ *   solver's member variables to describe the problem in a way that *
+ *   can be solved by the Hungarian method.  There are two changes   *
+ *   that setupProblem() must make to the original representation of *
+ *   the problem:                                                    *
  *                                                                   *
  *     1. Remove duplicate ROW_COL_COST's.  All but the lowest-cost  *
  *        rcc for any given row/column pair must be discarded.  They *
@@ -76,7 +77,7 @@
  *   in the subgraph.                                                *
  *                                                                   *
  *   In this code, the subgraph is represented by the array          *
- *   g_possMatesForRow.  For each row, g_possMatesForRow gives a     *
+ *   m_possMateForRow.  For each row, m_possMateForRow gives a       *
  *   list of columns that the row may be assigned to.  Arcs          *
  *   (ROW_COL_COST's) that are used in the subgraph are referred to  *
  *   in the comments as "enabled".                                   *
@@ -104,6 +105,41 @@
  *   burried in the middle of the loop), then the problem cannot be  *
  *   solved, and it returns UNSOLVABLE.                              *
  *                                                                   *
+ *   When the method is SHORTEST_PATH_ASSIGN, the same squared-up    *
+ *   problem built by setupProblem() is handed instead to            *
+ *   solveByShortestPaths().  This keeps a potential for every row   *
+ *   and every column, such that                                     *
+ *                                                                   *
+ *     cost - rowPotential[ row ] - colPotential[ col ] >= 0         *
+ *                                                                   *
+ *   for every arc (the "reduced cost"), with equality on the arcs   *
+ *   in the current matching.  setupShortestPaths() assigns most     *
+ *   rows cheaply, using the "augmenting row reduction" of           *
+ *                                                                   *
+ *     Jonker and Volgenant                                          *
+ *     A Shortest Augmenting Path Algorithm for Dense and Sparse     *
+ *     Linear Assignment Problems                                    *
+ *     Computing 38, 1987, pp 325-340                                *
+ *                                                                   *
+ *   Each row that is still unassigned is                            *
+ *   then given a mate by shortestPath(), which runs Dijkstra's      *
+ *   algorithm over reduced costs, from the unassigned row to the    *
+ *   nearest unassigned column, and flips the matching along the     *
+ *   path it finds.  The potentials are then adjusted so that the    *
+ *   reduced costs stay non-negative.                                *
+ *                                                                   *
+ *   The shortest-path method can also start from the potentials     *
+ *   and matching saved (in an ASSIGNMENT_DUALS) from a problem that *
+ *   this one is a subproblem of.  startFromDuals() copies the       *
+ *   potentials, which are still feasible, and keeps each old        *
+ *   assignment whose arc is still there at the same cost.  Then     *
+ *   only the rows that lost their mates go to shortestPath().       *
+ *                                                                   *
+ *   The arcs of each row are reached through m_firstArcOfRow and    *
+ *   m_arcOfRow, so a search only touches the part of the graph it   *
+ *   explores, and no set of "zero-cost" arcs is ever built by       *
+ *   comparing floating-point costs with 0.                          *
+ *                                                                   *
  * ----------------------------------------------------------------- *
  *                                                                   *
  *             Copyright (c) 1993, NEC Research Institute            *
@@ -137,6 +173,7 @@
 #include <stdlib.h>
 
 #include "mht/queue.h"
+#include "mht/pqueue.h"
 #include "mht/assign.h"
 
 /*-------------------------------------------------------------------*
@@ -149,18 +186,14 @@ static const int END_OF_PATIENCE = 10000;
 static const double SOLVED = 0.;
 static const int CANT_AUGMENT = 0;
 static const int AUGMENTED = 1;
+static const char UNREACHED = 0;
+static const char REACHED = 1;
+static const char SCANNED = 2;
 
 /*-------------------------------------------------------------------*
  | Static routines
  *-------------------------------------------------------------------*/
 
-static void setupProblem( ROW_COL_COST *rcc, int numRCCs,
-                          int numRows, int numCols );
-static void jumpStartProblem();
-static double solveProblem();
-static int augment();
-static double storeSolution( VECTOR_OF< void * > &tag, int *numTags );
-
 static inline int anti( int rowOrCol )
 {
     return -rowOrCol - 1;
@@ -170,51 +203,11 @@ static inline int anti( int rowOrCol )
  | Static global variables
  *-------------------------------------------------------------------*/
 
-static int g_minRow, g_maxRow;        // range of row numbers that
-//   appear in rcc's
-static int g_minCol, g_maxCol;        // range of column numbers that
-//   appear in rcc's
-
-static VECTOR_OF< ROW_COL_COST > g_rcc; // list of rcc's in problem
-static int g_numRCCs;                 // number of rcc's in problem
-
-static int g_numAssignmentsNeeded;    // number of assignments required
-//   for a complete solution
-static int g_numAssignmentsMade;      // number of assignments that have
-//   been made so far
-
-static VECTOR_OF< double > g_minCostInRow; // minimum cost of possible
-//   assignments for rows
-static VECTOR_OF< double > g_minCostInCol; // minimum cost of possible
-//   assignments for columns
-
-static VECTOR_OF< VECTOR_OF< int > > g_possMateForRow; // This is a
-//   two dimensional array.
-//   g_possMateForRow[r][i] is
-//   the column number of the
-//   i'th column that may be
-//   assigned to row r (counting
-//   only those rcc's that are
-//   currently enabled)
-static VECTOR_OF< int > g_numPossMatesForRow; // number of entries in
-//   g_possMateForRow for each
-//   row
-
-static VECTOR_OF< int > g_mateForRow; // current best column to assign
-//   each row to
-static VECTOR_OF< int > g_mateForCol; // current best row to assign
-//   each column to
-
-static QUEUE_OF< int > g_rowToSearch( 0 ); // next row to search for
-//   possible augmentation
-static VECTOR_OF< int > g_rowPredecessor; // g_rowPredecessor[r] is the
-//   number of the row that led
-//   to row r being searched for
-//   an augmentation
-
-static VECTOR_OF< char > g_rowIsEssential; // labels for essential rows
-static VECTOR_OF< char > g_colIsEssential; // labels for essential
-//   columns
+static ASSIGN_METHOD g_assignMethod = HUNGARIAN_ASSIGN; // algorithm
+//   used by solvers that
+//   haven't been given one
+static ASSIGNMENT_SOLVER g_solver;    // solver used by
+//   FindBestAssignment()
 
 /*-------------------------------------------------------------------*
  | SortAssignmentProblem() -- use qsort to sort an array of
@@ -263,7 +256,7 @@ static int compareRCCs( const void *addr0, const void *addr1 )
 
 /*-------------------------------------------------------------------*
  | FindBestAssignment() -- find the lowest-cost solution to an
- |                         assignment problem
+ |                         assignment problem, using the shared solver
  *-------------------------------------------------------------------*/
 
 double FindBestAssignment( ROW_COL_COST *rcc, int numRCCs,
@@ -279,6 +272,54 @@ double FindBestAssignment( ROW_COL_COST *rcc, int numRCCs,
         G_maxAssignSize = numRCCs;
     }
 
+    return g_solver.findBestAssignment( rcc, numRCCs, numRows, numCols,
+                                        tag, numTags );
+}
+
+/*-------------------------------------------------------------------*
+ | SetAssignmentMethod() -- choose the algorithm used by
+ |                          FindBestAssignment(), and by any
+ |                          ASSIGNMENT_SOLVER that hasn't been given
+ |                          one of its own
+ *-------------------------------------------------------------------*/
+
+void SetAssignmentMethod( ASSIGN_METHOD method )
+{
+    g_assignMethod = method;
+}
+
+ASSIGN_METHOD GetAssignmentMethod()
+{
+    return g_assignMethod;
+}
+
+/*-------------------------------------------------------------------*
+ | ASSIGNMENT_SOLVER::getMethod() -- get the algorithm this solver
+ |                                   uses
+ *-------------------------------------------------------------------*/
+
+ASSIGN_METHOD ASSIGNMENT_SOLVER::getMethod() const
+{
+    return m_methodIsSet ? m_method : g_assignMethod;
+}
+
+/*-------------------------------------------------------------------*
+ | ASSIGNMENT_SOLVER::findBestAssignment() -- find the lowest-cost
+ |                                            solution to an
+ |                                            assignment problem
+ *-------------------------------------------------------------------*/
+
+double ASSIGNMENT_SOLVER::
+findBestAssignment( ROW_COL_COST *rcc, int numRCCs,
+                    int numRows, int numCols,
+                    VECTOR_OF< void * > &tag, int *numTags )
+{
+
+
+    double result;
+
+    countCall( numRCCs );
+
     if( numRCCs == 0 )
     {
         *numTags = 0;
@@ -286,9 +327,18 @@ double FindBestAssignment( ROW_COL_COST *rcc, int numRCCs,
     }
 
     setupProblem( rcc, numRCCs, numRows, numCols );
-    jumpStartProblem();
 
-    if( solveProblem() == UNSOLVABLE )
+    if( getMethod() == SHORTEST_PATH_ASSIGN )
+    {
+        result = solveByShortestPaths();
+    }
+    else
+    {
+        jumpStartProblem();
+        result = solveProblem();
+    }
+
+    if( result == UNSOLVABLE )
     {
         return UNSOLVABLE;
     }
@@ -299,13 +349,68 @@ double FindBestAssignment( ROW_COL_COST *rcc, int numRCCs,
 }
 
 /*-------------------------------------------------------------------*
- | setupProblem() -- initialize global variables
+ | ASSIGNMENT_SOLVER::findBestAssignment() -- find the lowest-cost
+ |                                            solution by shortest
+ |                                            paths, starting from an
+ |                                            earlier solution
+ |
+ | If 'startingDuals' is given, it must have been saved from a
+ | problem that this one is a subproblem of.  The potentials and
+ | matching of the solution found are saved in 'finalDuals'.
+ *-------------------------------------------------------------------*/
+
+double ASSIGNMENT_SOLVER::
+findBestAssignment( ROW_COL_COST *rcc, int numRCCs,
+                    int numRows, int numCols,
+                    ASSIGNMENT_DUALS *startingDuals,
+                    ASSIGNMENT_DUALS &finalDuals,
+                    VECTOR_OF< void * > &tag, int *numTags )
+{
+
+
+    double result;
+
+    countCall( numRCCs );
+
+    finalDuals.m_minRow = 0;
+    finalDuals.m_maxRow = -1;
+    finalDuals.m_minCol = 0;
+    finalDuals.m_maxCol = -1;
+
+    if( numRCCs == 0 )
+    {
+        *numTags = 0;
+        return 0.;
+    }
+
+    setupProblem( rcc, numRCCs, numRows, numCols );
+
+    if( startingDuals != 0 && startFromDuals( *startingDuals ) )
+    {
+        result = assignFreeRows();
+    }
+    else
+    {
+        result = solveByShortestPaths();
+    }
+
+    if( result == UNSOLVABLE )
+    {
+        return UNSOLVABLE;
+    }
+
+    saveDuals( finalDuals );
+    return storeSolution( tag, numTags );
+}
+
+/*-------------------------------------------------------------------*
+ | setupProblem() -- initialize the solver's working storage
  |
  | See header comments for more details.
  *-------------------------------------------------------------------*/
 
-static void setupProblem( ROW_COL_COST *rcc, int numRCCs,
-                          int numRows, int numCols )
+void ASSIGNMENT_SOLVER::setupProblem( ROW_COL_COST *rcc, int numRCCs,
+                                      int numRows, int numCols )
 {
 
 
@@ -314,26 +419,26 @@ static void setupProblem( ROW_COL_COST *rcc, int numRCCs,
 
     /* fill in all the globals with starting values, and resizes all the
        arrays so that they'll be big enough for the given problem */
-    g_minRow = MAX_INTEGER;
-    g_maxRow = -MAX_INTEGER;
-    g_minCol = MAX_INTEGER;
-    g_maxCol = -MAX_INTEGER;
-    g_rcc.resize( 2 * numRCCs );
-    g_numRCCs = 0;
-    g_numAssignmentsNeeded = 0;
-    g_numAssignmentsMade = 0;
-    g_possMateForRow.resize( -numCols, numRows );
-    g_numPossMatesForRow.resize( -numCols, numRows );
-    g_numPossMatesForRow.clear();
-    g_mateForRow.resize( -numCols, numRows );
-    g_mateForCol.resize( -numRows, numCols );
-    g_minCostInRow.resize( numRows );
-    g_minCostInCol.resize( numCols );
-    g_rowToSearch.clear();
-    g_rowToSearch.resize( numRows + numCols );
-    g_rowPredecessor.resize( -numCols, numRows );
-    g_rowIsEssential.resize( -numCols, numRows );
-    g_colIsEssential.resize( -numRows, numCols );
+    m_minRow = MAX_INTEGER;
+    m_maxRow = -MAX_INTEGER;
+    m_minCol = MAX_INTEGER;
+    m_maxCol = -MAX_INTEGER;
+    m_rcc.resize( 2 * numRCCs );
+    m_numRCCs = 0;
+    m_numAssignmentsNeeded = 0;
+    m_numAssignmentsMade = 0;
+    m_possMateForRow.resize( -numCols, numRows );
+    m_numPossMatesForRow.resize( -numCols, numRows );
+    m_numPossMatesForRow.clear();
+    m_mateForRow.resize( -numCols, numRows );
+    m_mateForCol.resize( -numRows, numCols );
+    m_minCostInRow.resize( numRows );
+    m_minCostInCol.resize( numCols );
+    m_rowToSearch.clear();
+    m_rowToSearch.resize( numRows + numCols );
+    m_rowPredecessor.resize( -numCols, numRows );
+    m_rowIsEssential.resize( -numCols, numRows );
+    m_colIsEssential.resize( -numRows, numCols );
 
     /* convert the problem to a form that can be solved by
        the Hungarian method */
@@ -361,22 +466,22 @@ static void setupProblem( ROW_COL_COST *rcc, int numRCCs,
              and an RCC saying that the corresponding anti-row may be
              assigned to the corresponding anti-column */
         if( rcc[ i ].row < 0 )
-            g_rcc[ g_numRCCs++ ].set( anti( rcc[ i ].col ),
+            m_rcc[ m_numRCCs++ ].set( anti( rcc[ i ].col ),
                                       rcc[ i ].col,
                                       rcc[ i ].cost,
                                       &rcc[ i ] );
         else if( rcc[ i ].col < 0 )
-            g_rcc[ g_numRCCs++ ].set( rcc[ i ].row,
+            m_rcc[ m_numRCCs++ ].set( rcc[ i ].row,
                                       anti( rcc[ i ].row ),
                                       rcc[ i ].cost,
                                       &rcc[ i ] );
         else
         {
-            g_rcc[ g_numRCCs++ ].set( rcc[ i ].row,
+            m_rcc[ m_numRCCs++ ].set( rcc[ i ].row,
                                       rcc[ i ].col,
                                       rcc[ i ].cost,
                                       &rcc[ i ] );
-            g_rcc[ g_numRCCs++ ].set( anti( rcc[ i ].col ),
+            m_rcc[ m_numRCCs++ ].set( anti( rcc[ i ].col ),
                                       anti( rcc[ i ].row ),
                                       0.,
                                       0 );
@@ -386,48 +491,48 @@ static void setupProblem( ROW_COL_COST *rcc, int numRCCs,
     /* find the true minimum and maximum row and column numbers
        (including anti-rows and anti-columns), and count the maximum
        number of possible mates for each row */
-    for( i = 0; i < g_numRCCs; i++ )
+    for( i = 0; i < m_numRCCs; i++ )
     {
-        row = g_rcc[ i ].row;
-        col = g_rcc[ i ].col;
+        row = m_rcc[ i ].row;
+        col = m_rcc[ i ].col;
 
-        if( row < g_minRow )
+        if( row < m_minRow )
         {
-            g_minRow = row;
+            m_minRow = row;
         }
-        if( row > g_maxRow )
+        if( row > m_maxRow )
         {
-            g_maxRow = row;
+            m_maxRow = row;
         }
-        if( col < g_minCol )
+        if( col < m_minCol )
         {
-            g_minCol = col;
+            m_minCol = col;
         }
-        if( col > g_maxCol )
+        if( col > m_maxCol )
         {
-            g_maxCol = col;
+            m_maxCol = col;
         }
 
-        if( g_numPossMatesForRow[ g_rcc[ i ].row ]++ == 0 )
+        if( m_numPossMatesForRow[ m_rcc[ i ].row ]++ == 0 )
         {
-            g_numAssignmentsNeeded++;
+            m_numAssignmentsNeeded++;
         }
     }
 
-    /* make g_possMateForRow big enough for this problem */
-    for( i = g_minRow; i <= g_maxRow; i++ )
+    /* make m_possMateForRow big enough for this problem */
+    for( i = m_minRow; i <= m_maxRow; i++ )
     {
-        g_possMateForRow[ i ].resize( g_numPossMatesForRow[ i ] );
+        m_possMateForRow[ i ].resize( m_numPossMatesForRow[ i ] );
     }
 
     /* initialize the lists of assignments to nothing */
-    for( i = g_minRow; i <= g_maxRow; i++ )
+    for( i = m_minRow; i <= m_maxRow; i++ )
     {
-        g_mateForRow[ i ] = NO_SUCH_THING;
+        m_mateForRow[ i ] = NO_SUCH_THING;
     }
-    for( i = g_minCol; i <= g_maxCol; i++ )
+    for( i = m_minCol; i <= m_maxCol; i++ )
     {
-        g_mateForCol[ i ] = NO_SUCH_THING;
+        m_mateForCol[ i ] = NO_SUCH_THING;
     }
 }
 
@@ -438,7 +543,7 @@ static void setupProblem( ROW_COL_COST *rcc, int numRCCs,
  | See header comments for more details.
  *-------------------------------------------------------------------*/
 
-static void jumpStartProblem()
+void ASSIGNMENT_SOLVER::jumpStartProblem()
 {
 
 
@@ -446,23 +551,23 @@ static void jumpStartProblem()
     register int i;
 
     /* initialize the arrays of minimum costs */
-    for( i = 0; i <= g_maxRow; i++ )
+    for( i = 0; i <= m_maxRow; i++ )
     {
-        g_minCostInRow[ i ] = INFINITY;
+        m_minCostInRow[ i ] = INFINITY;
     }
-    for( i = 0; i <= g_maxCol; i++ )
+    for( i = 0; i <= m_maxCol; i++ )
     {
-        g_minCostInCol[ i ] = INFINITY;
+        m_minCostInCol[ i ] = INFINITY;
     }
 
     /* find the cost of the cheapest possible assignment for each row */
-    for( i = 0; i < g_numRCCs; i++ )
+    for( i = 0; i < m_numRCCs; i++ )
     {
-        row = g_rcc[ i ].row;
+        row = m_rcc[ i ].row;
 
-        if( row >= 0 && g_rcc[ i ].cost < g_minCostInRow[ row ] )
+        if( row >= 0 && m_rcc[ i ].cost < m_minCostInRow[ row ] )
         {
-            g_minCostInRow[ row ] = g_rcc[ i ].cost;
+            m_minCostInRow[ row ] = m_rcc[ i ].cost;
         }
     }
 
@@ -470,19 +575,19 @@ static void jumpStartProblem()
        the possible assignments in that row (so the cheapest one will go
        to 0), and find the cost of the cheapest resulting possible
        assignment for each column */
-    for( i = 0; i < g_numRCCs; i++ )
+    for( i = 0; i < m_numRCCs; i++ )
     {
-        row = g_rcc[ i ].row;
-        col = g_rcc[ i ].col;
+        row = m_rcc[ i ].row;
+        col = m_rcc[ i ].col;
 
         if( row >= 0 )
         {
-            g_rcc[ i ].cost -= g_minCostInRow[ row ];
+            m_rcc[ i ].cost -= m_minCostInRow[ row ];
         }
 
-        if( col >= 0 && g_rcc[ i ].cost < g_minCostInCol[ col ] )
+        if( col >= 0 && m_rcc[ i ].cost < m_minCostInCol[ col ] )
         {
-            g_minCostInCol[ col ] = g_rcc[ i ].cost;
+            m_minCostInCol[ col ] = m_rcc[ i ].cost;
         }
     }
 
@@ -490,27 +595,27 @@ static void jumpStartProblem()
        all the possible assignments in that column, if the resulting
        cost is 0, enable that assignment, and try to use it in our
        trivial solution */
-    g_numPossMatesForRow.clear();
-    for( i = 0; i < g_numRCCs; i++ )
+    m_numPossMatesForRow.clear();
+    for( i = 0; i < m_numRCCs; i++ )
     {
-        row = g_rcc[ i ].row;
-        col = g_rcc[ i ].col;
+        row = m_rcc[ i ].row;
+        col = m_rcc[ i ].col;
 
         if( col >= 0 )
         {
-            g_rcc[ i ].cost -= g_minCostInCol[ col ];
+            m_rcc[ i ].cost -= m_minCostInCol[ col ];
         }
 
-        if( g_rcc[ i ].cost == 0 )
+        if( m_rcc[ i ].cost == 0 )
         {
-            g_possMateForRow[ row ][ g_numPossMatesForRow[ row ]++ ] = col;
+            m_possMateForRow[ row ][ m_numPossMatesForRow[ row ]++ ] = col;
 
-            if( g_mateForRow[ row ] == NO_SUCH_THING &&
-                    g_mateForCol[ col ] == NO_SUCH_THING )
+            if( m_mateForRow[ row ] == NO_SUCH_THING &&
+                    m_mateForCol[ col ] == NO_SUCH_THING )
             {
-                g_mateForRow[ row ] = col;
-                g_mateForCol[ col ] = row;
-                g_numAssignmentsMade++;
+                m_mateForRow[ row ] = col;
+                m_mateForCol[ col ] = row;
+                m_numAssignmentsMade++;
             }
         }
     }
@@ -522,13 +627,13 @@ static void jumpStartProblem()
  | See header comments for more details.
  *-------------------------------------------------------------------*/
 
-static double solveProblem()
+double ASSIGNMENT_SOLVER::solveProblem()
 {
 
 
 #ifdef DEBUG
     int numIterationsWithoutProgress = 0;
-    int oldNumAssignmentsMade = g_numAssignmentsMade;
+    int oldNumAssignmentsMade = m_numAssignmentsMade;
 #endif
 
     double minCost;
@@ -537,7 +642,7 @@ static double solveProblem()
     register int i;
 
     /* main loop -- repeat until problem is solved */
-    while( g_numAssignmentsMade < g_numAssignmentsNeeded )
+    while( m_numAssignmentsMade < m_numAssignmentsNeeded )
     {
         /* try to increase the number of assignments made using the
            current subgraph */
@@ -552,7 +657,7 @@ static double solveProblem()
                number of assignments we can make in our matching, then
                there's probably something wrong */
 #ifdef DEBUG
-            if( g_numAssignmentsMade == oldNumAssignmentsMade )
+            if( m_numAssignmentsMade == oldNumAssignmentsMade )
             {
                 assert( ++numIterationsWithoutProgress < END_OF_PATIENCE );
                 //  THROW_ERR( "Giving up on Hungarian after " <<
@@ -563,26 +668,26 @@ static double solveProblem()
             {
                 numIterationsWithoutProgress = 0;
             }
-            oldNumAssignmentsMade = g_numAssignmentsMade;
+            oldNumAssignmentsMade = m_numAssignmentsMade;
 #endif
 
             /* see Cooper & Steinberg to help understand the following */
 
             /* find essential rows */
-            for( i = g_minRow; i <= g_maxRow; i++ )
-                g_rowIsEssential[ i ] =
-                    (g_mateForRow[ i ] != NO_SUCH_THING &&
-                     ! g_colIsEssential[ g_mateForRow[ i ] ]);
+            for( i = m_minRow; i <= m_maxRow; i++ )
+                m_rowIsEssential[ i ] =
+                    (m_mateForRow[ i ] != NO_SUCH_THING &&
+                     ! m_colIsEssential[ m_mateForRow[ i ] ]);
 
             /* find minimum cost assignment of a non-essential row to a
                non-essential column */
             minCost = INFINITY;
-            for( i = 0; i < g_numRCCs; i++ )
-                if( ! g_rowIsEssential[ g_rcc[ i ].row ] &&
-                        ! g_colIsEssential[ g_rcc[ i ].col ] &&
-                        g_rcc[ i ].cost < minCost )
+            for( i = 0; i < m_numRCCs; i++ )
+                if( ! m_rowIsEssential[ m_rcc[ i ].row ] &&
+                        ! m_colIsEssential[ m_rcc[ i ].col ] &&
+                        m_rcc[ i ].cost < minCost )
                 {
-                    minCost = g_rcc[ i ].cost;
+                    minCost = m_rcc[ i ].cost;
                 }
 
             /* if there is no minimum cost assignment between a non-essential
@@ -598,29 +703,29 @@ static double solveProblem()
 #endif
 
             /* construct the new subgraph */
-            g_numPossMatesForRow.clear();
-            for( i = 0; i < g_numRCCs; i++ )
+            m_numPossMatesForRow.clear();
+            for( i = 0; i < m_numRCCs; i++ )
             {
-                row = g_rcc[ i ].row;
-                col = g_rcc[ i ].col;
+                row = m_rcc[ i ].row;
+                col = m_rcc[ i ].col;
 
-                if( g_rowIsEssential[ row ] )
+                if( m_rowIsEssential[ row ] )
                 {
-                    if( g_colIsEssential[ col ] )
+                    if( m_colIsEssential[ col ] )
                     {
-                        g_rcc[ i ].cost += minCost;
+                        m_rcc[ i ].cost += minCost;
                     }
                 }
                 else
                 {
-                    if( ! g_colIsEssential[ col ] )
+                    if( ! m_colIsEssential[ col ] )
                     {
-                        g_rcc[ i ].cost -= minCost;
+                        m_rcc[ i ].cost -= minCost;
                     }
                 }
 
-                if( g_rcc[ i ].cost == 0 )
-                    g_possMateForRow[ row ][ g_numPossMatesForRow[ row ]++ ] =
+                if( m_rcc[ i ].cost == 0 )
+                    m_possMateForRow[ row ][ m_numPossMatesForRow[ row ]++ ] =
                         col;
             }
         }
@@ -636,7 +741,7 @@ static double solveProblem()
  | See header comments for more details.
  *-------------------------------------------------------------------*/
 
-static int augment()
+int ASSIGNMENT_SOLVER::augment()
 {
 
 
@@ -647,32 +752,32 @@ static int augment()
 
     /* see Cooper & Steinberg to help understand the following */
 
-    g_colIsEssential.clear();
-    g_rowToSearch.clear();
+    m_colIsEssential.clear();
+    m_rowToSearch.clear();
 
     /* make list of rows to search -- we'll begin by searching any
        row which isn't yet assigned */
-    for( row = g_minRow; row <= g_maxRow; row++ )
+    for( row = m_minRow; row <= m_maxRow; row++ )
     {
-        g_rowPredecessor[ row ] = NO_SUCH_THING;
-        if( g_mateForRow[ row ] == NO_SUCH_THING )
+        m_rowPredecessor[ row ] = NO_SUCH_THING;
+        if( m_mateForRow[ row ] == NO_SUCH_THING )
         {
-            g_rowToSearch.put( row );
+            m_rowToSearch.put( row );
         }
     }
 
     /* keep searching until we've run out of rows to search */
-    while( ! g_rowToSearch.isEmpty() )
+    while( ! m_rowToSearch.isEmpty() )
     {
         /* get one of the rows to search */
-        row = g_rowToSearch.get();
+        row = m_rowToSearch.get();
 
         /* go through each of the possible assignments for this
            row in the current subgraph */
-        for( i = 0; i < g_numPossMatesForRow[ row ]; i++ )
+        for( i = 0; i < m_numPossMatesForRow[ row ]; i++ )
         {
-            col = g_possMateForRow[ row ][ i ];
-            mateForCol = g_mateForCol[ col ];
+            col = m_possMateForRow[ row ][ i ];
+            mateForCol = m_mateForCol[ col ];
 
             /* if the row can be assigned to this column (because the
                column doesn't already have a mate), then we can get an
@@ -681,28 +786,28 @@ static int augment()
             {
                 do
                 {
-                    oldMateForRow = g_mateForRow[ row ];
-                    g_mateForRow[ row ] = col;
-                    g_mateForCol[ col ] = row;
+                    oldMateForRow = m_mateForRow[ row ];
+                    m_mateForRow[ row ] = col;
+                    m_mateForCol[ col ] = row;
 
-                    row = g_rowPredecessor[ row ];
+                    row = m_rowPredecessor[ row ];
                     col = oldMateForRow;
                 }
                 while( row != NO_SUCH_THING );
 
-                g_numAssignmentsMade++;
+                m_numAssignmentsMade++;
 
                 return AUGMENTED;
             }
 
             /* otherwise, search the row that this column is assigned to,
                trying to find a different column to assign it to */
-            if( g_rowPredecessor[ mateForCol ] == NO_SUCH_THING )
+            if( m_rowPredecessor[ mateForCol ] == NO_SUCH_THING )
             {
-                g_rowPredecessor[ mateForCol ] = row;
-                g_rowToSearch.put( mateForCol );
+                m_rowPredecessor[ mateForCol ] = row;
+                m_rowToSearch.put( mateForCol );
 
-                g_colIsEssential[ col ] = 1;
+                m_colIsEssential[ col ] = 1;
             }
         }
     }
@@ -711,11 +816,494 @@ static int augment()
 }
 
 
+/*-------------------------------------------------------------------*
+ | solveByShortestPaths() -- solve the problem by successive shortest
+ |                           augmenting paths
+ |
+ | See header comments for more details.
+ *-------------------------------------------------------------------*/
+
+double ASSIGNMENT_SOLVER::solveByShortestPaths()
+{
+
+
+    setupShortestPaths();
+
+    return assignFreeRows();
+}
+
+/*-------------------------------------------------------------------*
+ | assignFreeRows() -- give a mate to every row that doesn't have one
+ *-------------------------------------------------------------------*/
+
+double ASSIGNMENT_SOLVER::assignFreeRows()
+{
+
+
+    register int row;
+
+    for( row = m_minRow; row <= m_maxRow; row++ )
+        if( m_mateForRow[ row ] == NO_SUCH_THING &&
+                m_firstArcOfRow[ row ] < m_firstArcOfRow[ row + 1 ] &&
+                shortestPath( row ) == CANT_AUGMENT )
+        {
+            return UNSOLVABLE;
+        }
+
+    return SOLVED;
+}
+
+/*-------------------------------------------------------------------*
+ | indexArcsByRow() -- size the shortest-path working storage, and
+ |                     group the arcs by row
+ *-------------------------------------------------------------------*/
+
+void ASSIGNMENT_SOLVER::indexArcsByRow()
+{
+
+
+    register int row;
+    register int i;
+
+    m_firstArcOfRow.resize( m_minRow, m_maxRow + 1 );
+    m_arcOfRow.resize( m_numRCCs );
+    m_rowPotential.resize( m_minRow, m_maxRow );
+    m_colPotential.resize( m_minCol, m_maxCol );
+    m_pathCost.resize( m_minCol, m_maxCol );
+    m_colPredecessor.resize( m_minCol, m_maxCol );
+    m_colState.resize( m_minCol, m_maxCol );
+    m_colState.clear();
+    m_touchedCol.resize( m_maxCol - m_minCol );
+    m_freeRow.resize( m_maxRow - m_minRow );
+    m_colToScan.clear();
+    m_colToScan.resize( m_numRCCs );
+
+    /* setupProblem() left the number of arcs out of each row in
+       m_numPossMatesForRow -- use it to group the arcs by row */
+    m_firstArcOfRow[ m_minRow ] = 0;
+    for( row = m_minRow; row <= m_maxRow; row++ )
+    {
+        m_firstArcOfRow[ row + 1 ] =
+            m_firstArcOfRow[ row ] + m_numPossMatesForRow[ row ];
+        m_numPossMatesForRow[ row ] = 0;
+    }
+    for( i = 0; i < m_numRCCs; i++ )
+    {
+        row = m_rcc[ i ].row;
+        m_arcOfRow[ m_firstArcOfRow[ row ] +
+                    m_numPossMatesForRow[ row ]++ ] = i;
+    }
+}
+
+/*-------------------------------------------------------------------*
+ | setupShortestPaths() -- index the arcs by row, find a feasible set
+ |                         of potentials, and make as many cheap
+ |                         assignments as possible
+ *-------------------------------------------------------------------*/
+
+void ASSIGNMENT_SOLVER::setupShortestPaths()
+{
+
+
+    double reducedCost;
+    double minCost, secondCost;
+    double newPotential;
+    int bestCol, secondCol;
+    int oldMateForCol;
+    int potentialMoved;
+    int numFreeRows, prevNumFreeRows;
+    int numRetries;
+    int pass;
+    register int row, col;
+    register int i, k;
+
+    indexArcsByRow();
+
+    /* each column starts with the cost of its cheapest arc as its
+       potential, so every reduced cost is non-negative */
+    for( col = m_minCol; col <= m_maxCol; col++ )
+    {
+        m_colPotential[ col ] = INFINITY;
+    }
+    for( i = 0; i < m_numRCCs; i++ )
+    {
+        col = m_rcc[ i ].col;
+
+        if( m_rcc[ i ].cost < m_colPotential[ col ] )
+        {
+            m_colPotential[ col ] = m_rcc[ i ].cost;
+        }
+    }
+
+    /* augmenting row reduction (Jonker & Volgenant) -- each free row
+       takes the column with the lowest reduced cost, lowering that
+       column's potential until the row is indifferent between it and
+       its second choice, and evicting the column's previous mate.  An
+       evicted row is retried at once if the potential moved, or left
+       for the next pass if it didn't.  Rows can evict each other
+       indefinitely when they compete for too few columns, so the
+       number of retries in a pass is limited.  Two passes leave few
+       rows for shortestPath() */
+    numFreeRows = 0;
+    for( row = m_minRow; row <= m_maxRow; row++ )
+        if( m_firstArcOfRow[ row ] < m_firstArcOfRow[ row + 1 ] )
+        {
+            m_freeRow[ numFreeRows++ ] = row;
+        }
+
+    for( pass = 0; pass < 2; pass++ )
+    {
+        prevNumFreeRows = numFreeRows;
+        numFreeRows = 0;
+        numRetries = 0;
+        k = 0;
+
+        while( k < prevNumFreeRows )
+        {
+            row = m_freeRow[ k++ ];
+
+            minCost = INFINITY;
+            secondCost = INFINITY;
+            bestCol = NO_SUCH_THING;
+            secondCol = NO_SUCH_THING;
+            for( i = m_firstArcOfRow[ row ];
+                    i < m_firstArcOfRow[ row + 1 ];
+                    i++ )
+            {
+                col = m_rcc[ m_arcOfRow[ i ] ].col;
+                reducedCost = m_rcc[ m_arcOfRow[ i ] ].cost -
+                              m_colPotential[ col ];
+
+                if( reducedCost < minCost )
+                {
+                    secondCost = minCost;
+                    secondCol = bestCol;
+                    minCost = reducedCost;
+                    bestCol = col;
+                }
+                else if( reducedCost < secondCost )
+                {
+                    secondCost = reducedCost;
+                    secondCol = col;
+                }
+            }
+
+            /* the potential only counts as moved if round-off didn't
+               swallow the change, otherwise two rows could keep
+               evicting each other forever */
+            oldMateForCol = m_mateForCol[ bestCol ];
+            newPotential = m_colPotential[ bestCol ];
+            if( secondCol != NO_SUCH_THING )
+            {
+                newPotential -= secondCost - minCost;
+            }
+            potentialMoved = (newPotential < m_colPotential[ bestCol ]);
+
+            if( potentialMoved )
+            {
+                m_colPotential[ bestCol ] = newPotential;
+            }
+            else if( oldMateForCol != NO_SUCH_THING &&
+                     secondCol != NO_SUCH_THING )
+            {
+                bestCol = secondCol;
+                oldMateForCol = m_mateForCol[ bestCol ];
+            }
+
+            m_mateForRow[ row ] = bestCol;
+            m_mateForCol[ bestCol ] = row;
+
+            if( oldMateForCol != NO_SUCH_THING )
+            {
+                m_mateForRow[ oldMateForCol ] = NO_SUCH_THING;
+
+                if( potentialMoved && numRetries++ < prevNumFreeRows )
+                {
+                    m_freeRow[ --k ] = oldMateForCol;
+                }
+                else
+                {
+                    m_freeRow[ numFreeRows++ ] = oldMateForCol;
+                }
+            }
+        }
+    }
+
+    /* each row's potential is the lowest reduced cost in the row (for
+       assigned rows, this is the cost of the assignment) */
+    for( row = m_minRow; row <= m_maxRow; row++ )
+    {
+        m_rowPotential[ row ] = 0.;
+        if( m_mateForRow[ row ] != NO_SUCH_THING )
+        {
+            m_numAssignmentsMade++;
+        }
+
+        minCost = INFINITY;
+        for( i = m_firstArcOfRow[ row ]; i < m_firstArcOfRow[ row + 1 ]; i++ )
+        {
+            col = m_rcc[ m_arcOfRow[ i ] ].col;
+            reducedCost = m_rcc[ m_arcOfRow[ i ] ].cost - m_colPotential[ col ];
+
+            if( reducedCost < minCost )
+            {
+                minCost = reducedCost;
+                m_rowPotential[ row ] = minCost;
+            }
+        }
+    }
+}
+
+/*-------------------------------------------------------------------*
+ | startFromDuals() -- take the potentials and matching from the
+ |                     solution of a problem that this one is a
+ |                     subproblem of
+ |
+ | Returns 0, having done nothing, if this problem has rows or columns
+ | that weren't in the old one.
+ *-------------------------------------------------------------------*/
+
+int ASSIGNMENT_SOLVER::startFromDuals( ASSIGNMENT_DUALS &duals )
+{
+
+
+    int arc;
+    register int row, col;
+    register int i;
+
+    if( m_minRow < duals.m_minRow || m_maxRow > duals.m_maxRow ||
+            m_minCol < duals.m_minCol || m_maxCol > duals.m_maxCol )
+    {
+        return 0;
+    }
+
+    indexArcsByRow();
+
+    for( col = m_minCol; col <= m_maxCol; col++ )
+    {
+        m_colPotential[ col ] = duals.m_colPotential[ col ];
+    }
+
+    /* an old assignment can be kept if its arc is still in the problem
+       -- the cost has to match too, since removing the cheapest of
+       several arcs between a row and a column leaves a dearer one,
+       which wouldn't have a reduced cost of 0 */
+    for( row = m_minRow; row <= m_maxRow; row++ )
+    {
+        m_rowPotential[ row ] = duals.m_rowPotential[ row ];
+
+        col = duals.m_mateForRow[ row ];
+        if( col == NO_SUCH_THING || col < m_minCol || col > m_maxCol )
+        {
+            continue;
+        }
+
+        for( i = m_firstArcOfRow[ row ]; i < m_firstArcOfRow[ row + 1 ]; i++ )
+        {
+            arc = m_arcOfRow[ i ];
+            if( m_rcc[ arc ].col == col )
+            {
+                if( m_rcc[ arc ].cost == duals.m_costOfMate[ row ] )
+                {
+                    m_mateForRow[ row ] = col;
+                    m_mateForCol[ col ] = row;
+                    m_numAssignmentsMade++;
+                }
+                break;
+            }
+        }
+    }
+
+    return 1;
+}
+
+/*-------------------------------------------------------------------*
+ | shortestPath() -- find the cheapest augmenting path from an
+ |                   unassigned row, and use it to assign that row
+ |
+ | See header comments for more details.
+ *-------------------------------------------------------------------*/
+
+int ASSIGNMENT_SOLVER::shortestPath( int freeRow )
+{
+
+
+    PATH_COST next;
+    double pathCost;
+    double reducedCost;
+    double sinkCost;
+    int sinkCol;
+    int numTouchedCols;
+    int oldMateForRow;
+    int arc;
+    register int row, col;
+    register int i;
+
+    numTouchedCols = 0;
+    sinkCol = NO_SUCH_THING;
+    sinkCost = 0.;
+    row = freeRow;
+
+    /* Dijkstra's algorithm, over columns -- each time a column is
+       scanned, the search continues through the row it's assigned to,
+       until an unassigned column is reached */
+    while( sinkCol == NO_SUCH_THING )
+    {
+        for( i = m_firstArcOfRow[ row ]; i < m_firstArcOfRow[ row + 1 ]; i++ )
+        {
+            arc = m_arcOfRow[ i ];
+            col = m_rcc[ arc ].col;
+
+            if( m_colState[ col ] == SCANNED )
+            {
+                continue;
+            }
+
+            /* round-off can leave tiny negative reduced costs on arcs
+               that should be exactly tight */
+            reducedCost = m_rcc[ arc ].cost -
+                          m_rowPotential[ row ] - m_colPotential[ col ];
+            if( reducedCost < 0. )
+            {
+                reducedCost = 0.;
+            }
+            pathCost = sinkCost + reducedCost;
+
+            if( m_colState[ col ] == UNREACHED )
+            {
+                m_colState[ col ] = REACHED;
+                m_touchedCol[ numTouchedCols++ ] = col;
+            }
+            else if( pathCost >= m_pathCost[ col ] )
+            {
+                continue;
+            }
+
+            m_pathCost[ col ] = pathCost;
+            m_colPredecessor[ col ] = row;
+            next.cost = pathCost;
+            next.col = col;
+            next.colIsFree = (m_mateForCol[ col ] == NO_SUCH_THING);
+            m_colToScan.put( next );
+        }
+
+        /* get the closest column that hasn't been scanned yet,
+           skipping entries that were superseded by cheaper paths */
+        do
+        {
+            if( m_colToScan.isEmpty() )
+            {
+                for( i = 0; i < numTouchedCols; i++ )
+                {
+                    m_colState[ m_touchedCol[ i ] ] = UNREACHED;
+                }
+                return CANT_AUGMENT;
+            }
+            next = m_colToScan.get();
+        }
+        while( m_colState[ next.col ] == SCANNED ||
+                next.cost > m_pathCost[ next.col ] );
+
+        col = next.col;
+        sinkCost = next.cost;
+        m_colState[ col ] = SCANNED;
+
+        if( m_mateForCol[ col ] == NO_SUCH_THING )
+        {
+            sinkCol = col;
+        }
+        else
+        {
+            row = m_mateForCol[ col ];
+        }
+    }
+
+    /* update the potentials so that every reduced cost stays
+       non-negative, and the arcs along the path become tight */
+    m_rowPotential[ freeRow ] += sinkCost;
+    for( i = 0; i < numTouchedCols; i++ )
+    {
+        col = m_touchedCol[ i ];
+
+        if( m_colState[ col ] == SCANNED && col != sinkCol )
+        {
+            m_rowPotential[ m_mateForCol[ col ] ] +=
+                sinkCost - m_pathCost[ col ];
+            m_colPotential[ col ] -= sinkCost - m_pathCost[ col ];
+        }
+
+        m_colState[ col ] = UNREACHED;
+    }
+    m_colToScan.clear();
+
+    /* flip the assignments along the path */
+    col = sinkCol;
+    do
+    {
+        row = m_colPredecessor[ col ];
+        oldMateForRow = m_mateForRow[ row ];
+        m_mateForRow[ row ] = col;
+        m_mateForCol[ col ] = row;
+        col = oldMateForRow;
+    }
+    while( row != freeRow );
+
+    m_numAssignmentsMade++;
+
+    return AUGMENTED;
+}
+
+/*-------------------------------------------------------------------*
+ | saveDuals() -- save the potentials and matching of a shortest-path
+ |                solution
+ *-------------------------------------------------------------------*/
+
+void ASSIGNMENT_SOLVER::saveDuals( ASSIGNMENT_DUALS &duals )
+{
+
+
+    int arc;
+    register int row, col;
+    register int i;
+
+    duals.m_minRow = m_minRow;
+    duals.m_maxRow = m_maxRow;
+    duals.m_minCol = m_minCol;
+    duals.m_maxCol = m_maxCol;
+    duals.m_rowPotential.resize( m_minRow, m_maxRow );
+    duals.m_colPotential.resize( m_minCol, m_maxCol );
+    duals.m_mateForRow.resize( m_minRow, m_maxRow );
+    duals.m_costOfMate.resize( m_minRow, m_maxRow );
+
+    for( row = m_minRow; row <= m_maxRow; row++ )
+    {
+        duals.m_rowPotential[ row ] = m_rowPotential[ row ];
+        duals.m_mateForRow[ row ] = m_mateForRow[ row ];
+        duals.m_costOfMate[ row ] = 0.;
+
+        for( i = m_firstArcOfRow[ row ]; i < m_firstArcOfRow[ row + 1 ]; i++ )
+        {
+            arc = m_arcOfRow[ i ];
+            if( m_rcc[ arc ].col == m_mateForRow[ row ] )
+            {
+                duals.m_costOfMate[ row ] = m_rcc[ arc ].cost;
+                break;
+            }
+        }
+    }
+
+    for( col = m_minCol; col <= m_maxCol; col++ )
+    {
+        duals.m_colPotential[ col ] = m_colPotential[ col ];
+    }
+}
+
 /*-------------------------------------------------------------------*
  | storeSolution() -- store the solution in a VECTOR
  *-------------------------------------------------------------------*/
 
-static double storeSolution( VECTOR_OF< void * > &tag, int *numTags )
+double ASSIGNMENT_SOLVER::storeSolution( VECTOR_OF< void * > &tag,
+                                         int *numTags )
 {
 
 
@@ -724,15 +1312,15 @@ static double storeSolution( VECTOR_OF< void * > &tag, int *numTags )
     int n;
     int i;
 
-    tag.resize( g_numAssignmentsMade );
+    tag.resize( m_numAssignmentsMade );
 
     cost = 0.;
     n = 0;
-    for( i = 0; i < g_numRCCs; i++ )
-        if( g_rcc[ i ].tag != 0 &&
-                g_rcc[ i ].row == g_mateForCol[ g_rcc[ i ].col ] )
+    for( i = 0; i < m_numRCCs; i++ )
+        if( m_rcc[ i ].tag != 0 &&
+                m_rcc[ i ].row == m_mateForCol[ m_rcc[ i ].col ] )
         {
-            usedRCC = (ROW_COL_COST *)g_rcc[ i ].tag;
+            usedRCC = (ROW_COL_COST *)m_rcc[ i ].tag;
             tag[ n++ ] = usedRCC->tag;
             cost += usedRCC->cost;
         }
@@ -741,3 +1329,33 @@ static double storeSolution( VECTOR_OF< void * > &tag, int *numTags )
 
     return cost;
 }
+
+/*-------------------------------------------------------------------*
+ | ASSIGNMENT_DUALS::getReducedCost() -- find the reduced cost of an
+ |                                       arc
+ |
+ | The arc is given as it appears in the original problem (a row or
+ | column of -1 means leaving the other unassigned).  Arcs that
+ | weren't in the problem the potentials came from get 0.
+ *-------------------------------------------------------------------*/
+
+double ASSIGNMENT_DUALS::getReducedCost( const ROW_COL_COST &rcc )
+{
+
+
+    double reducedCost;
+    int row, col;
+
+    row = rcc.row < 0 ? anti( rcc.col ) : rcc.row;
+    col = rcc.col < 0 ? anti( rcc.row ) : rcc.col;
+
+    if( row < m_minRow || row > m_maxRow ||
+            col < m_minCol || col > m_maxCol )
+    {
+        return 0.;
+    }
+
+    reducedCost = rcc.cost - m_rowPotential[ row ] - m_colPotential[ col ];
+
+    return reducedCost < 0. ? 0. : reducedCost;
+}
@@ -46,43 +46,21 @@ static const int NO_SUCH_THING = 0x7FFFFFFF;
 static const int MAX_INTEGER = 0x7FFFFFFF;
 static const double SOLVED = 0.;
 
-typedef
-VECTOR_OF< VECTOR_OF< ROW_COL_COST > >
-RCC_ARRAY_2D;
-
-static void setupProblem( ROW_COL_COST *rcc, int numRCCs, int, int );
-static double solveProblem();
-static void search( int level, double costSoFar );
-static double storeSolution( VECTOR_OF< void * > &tag, int *numTags );
-
-static int g_minRow;
-static int g_maxRow;
-static int g_minCol;
-static int g_maxCol;
-
-static int g_numRows;
-static int g_numCols;
-
-static RCC_ARRAY_2D g_rccForRow;
-static VECTOR_OF< int > g_numRCCsForRow;
-
-static RCC_ARRAY_2D g_rccForCol;
-static VECTOR_OF< int > g_numRCCsForCol;
-
-static VECTOR_OF< int > g_mateForRow;
-static VECTOR_OF< int > g_mateForCol;
-
-static VECTOR_OF< void * > g_solution;
-static int g_solutionSize;
-
-static VECTOR_OF< void * > g_bestSolution;
-static int g_bestSolutionSize;
-static double g_bestSolutionCost;
+static BASSIGNMENT_SOLVER g_solver;
 
 double BFindBestAssignment( ROW_COL_COST *rcc, int numRCCs,
                             int numRows, int numCols,
                             VECTOR_OF< void * > &tag, int *numTags )
 {
+    return g_solver.findBestAssignment( rcc, numRCCs, numRows, numCols,
+                                        tag, numTags );
+}
+
+double BASSIGNMENT_SOLVER::
+findBestAssignment( ROW_COL_COST *rcc, int numRCCs,
+                    int numRows, int numCols,
+                    VECTOR_OF< void * > &tag, int *numTags )
+{
 
 
     if( numRCCs == 0 )
@@ -103,23 +81,23 @@ double BFindBestAssignment( ROW_COL_COST *rcc, int numRCCs,
     }
 }
 
-static void setupProblem( ROW_COL_COST *rcc, int numRCCs,
-                          int numRows, int numCols )
+void BASSIGNMENT_SOLVER::setupProblem( ROW_COL_COST *rcc, int numRCCs,
+                                       int numRows, int numCols )
 {
 
 
     int row, col;
     int i;
 
-    g_minRow = MAX_INTEGER;
-    g_maxRow = -MAX_INTEGER;
-    g_minCol = MAX_INTEGER;
-    g_maxCol = -MAX_INTEGER;
-    g_numRCCsForRow.resize( numRows );
-    g_numRCCsForCol.resize( numCols );
+    m_minRow = MAX_INTEGER;
+    m_maxRow = -MAX_INTEGER;
+    m_minCol = MAX_INTEGER;
+    m_maxCol = -MAX_INTEGER;
+    m_numRCCsForRow.resize( numRows );
+    m_numRCCsForCol.resize( numCols );
 
-    g_numRCCsForRow.clear();
-    g_numRCCsForCol.clear();
+    m_numRCCsForRow.clear();
+    m_numRCCsForCol.clear();
     for( i = 0; i < numRCCs; i++ )
     {
         row = rcc[ i ].row;
@@ -127,27 +105,27 @@ static void setupProblem( ROW_COL_COST *rcc, int numRCCs,
 
         if( row >= 0 )
         {
-            g_numRCCsForRow[ row ]++;
+            m_numRCCsForRow[ row ]++;
         }
         if( col >= 0 )
         {
-            g_numRCCsForCol[ col ]++;
+            m_numRCCsForCol[ col ]++;
         }
     }
 
-    g_rccForRow.resize( numRows );
+    m_rccForRow.resize( numRows );
     for( i = 0; i < numRows; i++ )
     {
-        g_rccForRow[ i ].resize( g_numRCCsForRow[ i ] );
+        m_rccForRow[ i ].resize( m_numRCCsForRow[ i ] );
     }
-    g_rccForCol.resize( numCols );
+    m_rccForCol.resize( numCols );
     for( i = 0; i < numCols; i++ )
     {
-        g_rccForCol[ i ].resize( g_numRCCsForCol[ i ] );
+        m_rccForCol[ i ].resize( m_numRCCsForCol[ i ] );
     }
 
-    g_numRCCsForRow.clear();
-    g_numRCCsForCol.clear();
+    m_numRCCsForRow.clear();
+    m_numRCCsForCol.clear();
     for( i = 0; i < numRCCs; i++ )
     {
         row = rcc[ i ].row;
@@ -155,63 +133,63 @@ static void setupProblem( ROW_COL_COST *rcc, int numRCCs,
 
         if( row >= 0 )
         {
-            g_rccForRow[ row ][ g_numRCCsForRow[ row ]++ ] = rcc[ i ];
+            m_rccForRow[ row ][ m_numRCCsForRow[ row ]++ ] = rcc[ i ];
         }
         if( col >= 0 )
         {
-            g_rccForCol[ col ][ g_numRCCsForCol[ col ]++ ] = rcc[ i ];
+            m_rccForCol[ col ][ m_numRCCsForCol[ col ]++ ] = rcc[ i ];
         }
 
-        if( row < g_minRow )
+        if( row < m_minRow )
         {
-            g_minRow = row;
+            m_minRow = row;
         }
-        if( row > g_maxRow )
+        if( row > m_maxRow )
         {
-            g_maxRow = row;
+            m_maxRow = row;
         }
 
-        if( col < g_minCol )
+        if( col < m_minCol )
         {
-            g_minCol = col;
+            m_minCol = col;
         }
-        if( col > g_maxCol )
+        if( col > m_maxCol )
         {
-            g_maxCol = col;
+            m_maxCol = col;
         }
     }
 
-    g_numRows = g_maxRow - g_minRow + 1;
-    g_numCols = g_maxCol - g_minCol + 1;
+    m_numRows = m_maxRow - m_minRow + 1;
+    m_numCols = m_maxCol - m_minCol + 1;
 }
 
-static double solveProblem()
+double BASSIGNMENT_SOLVER::solveProblem()
 {
 
 
     int i;
 
-    g_mateForRow.resize( g_minRow, g_maxRow );
-    g_mateForCol.resize( g_minCol, g_maxCol );
-    g_solution.resize( g_numRows + g_numCols - 1 );
-    g_solutionSize = 0;
-    g_bestSolution.resize( g_numRows + g_numCols - 1 );
-    g_bestSolutionSize = 0;
-    g_bestSolutionCost = INFINITY;
+    m_mateForRow.resize( m_minRow, m_maxRow );
+    m_mateForCol.resize( m_minCol, m_maxCol );
+    m_solution.resize( m_numRows + m_numCols - 1 );
+    m_solutionSize = 0;
+    m_bestSolution.resize( m_numRows + m_numCols - 1 );
+    m_bestSolutionSize = 0;
+    m_bestSolutionCost = INFINITY;
 
-    for( i = g_minRow; i <= g_maxRow; i++ )
+    for( i = m_minRow; i <= m_maxRow; i++ )
     {
-        g_mateForRow[ i ] = NO_SUCH_THING;
+        m_mateForRow[ i ] = NO_SUCH_THING;
     }
 
-    for( i = g_minCol; i <= g_maxCol; i++ )
+    for( i = m_minCol; i <= m_maxCol; i++ )
     {
-        g_mateForCol[ i ] = NO_SUCH_THING;
+        m_mateForCol[ i ] = NO_SUCH_THING;
     }
 
     search( 0, 0. );
 
-    if( g_bestSolutionCost == INFINITY )
+    if( m_bestSolutionCost == INFINITY )
     {
         return UNSOLVABLE;
     }
@@ -221,101 +199,102 @@ static double solveProblem()
     }
 }
 
-static void search( int level, double costSoFar )
+void BASSIGNMENT_SOLVER::search( int level, double costSoFar )
 {
 
 
     int row, col;
     int i;
 
-    if( level <= g_maxRow )
+    if( level <= m_maxRow )
     {
 
         row = level;
 
-        if( row < g_minRow ||
-                g_mateForRow[ row ] != NO_SUCH_THING ||
-                g_numRCCsForRow[ row ] == 0 )
+        if( row < m_minRow ||
+                m_mateForRow[ row ] != NO_SUCH_THING ||
+                m_numRCCsForRow[ row ] == 0 )
         {
             search( level + 1, costSoFar );
         }
         else
-            for( i = 0; i < g_numRCCsForRow[ row ]; i++ )
+            for( i = 0; i < m_numRCCsForRow[ row ]; i++ )
             {
-                col = g_rccForRow[ row ][ i ].col;
-                if( g_mateForCol[ col ] == NO_SUCH_THING )
+                col = m_rccForRow[ row ][ i ].col;
+                if( m_mateForCol[ col ] == NO_SUCH_THING )
                 {
-                    g_mateForRow[ row ] = col;
+                    m_mateForRow[ row ] = col;
                     if( col >= 0 )
                     {
-                        g_mateForCol[ col ] = row;
+                        m_mateForCol[ col ] = row;
                     }
-                    g_solution[ g_solutionSize++ ] = g_rccForRow[ row ][ i ].tag;
+                    m_solution[ m_solutionSize++ ] = m_rccForRow[ row ][ i ].tag;
 
-                    search( level + 1, costSoFar + g_rccForRow[ row ][ i ].cost );
+                    search( level + 1, costSoFar + m_rccForRow[ row ][ i ].cost );
 
-                    g_solutionSize--;
-                    g_mateForCol[ col ] = NO_SUCH_THING;
-                    g_mateForRow[ row ] = NO_SUCH_THING;
+                    m_solutionSize--;
+                    m_mateForCol[ col ] = NO_SUCH_THING;
+                    m_mateForRow[ row ] = NO_SUCH_THING;
                 }
             }
     }
-    else if( level <= g_maxRow + 1 + g_maxCol )
+    else if( level <= m_maxRow + 1 + m_maxCol )
     {
 
-        col = level - g_maxRow - 1;
+        col = level - m_maxRow - 1;
 
-        if( col < g_minCol ||
-                g_mateForCol[ col ] != NO_SUCH_THING ||
-                g_numRCCsForCol[ col ] == 0 )
+        if( col < m_minCol ||
+                m_mateForCol[ col ] != NO_SUCH_THING ||
+                m_numRCCsForCol[ col ] == 0 )
         {
             search( level + 1, costSoFar );
         }
         else
-            for( i = 0; i < g_numRCCsForCol[ col ]; i++ )
+            for( i = 0; i < m_numRCCsForCol[ col ]; i++ )
             {
-                row = g_rccForCol[ col ][ i ].row;
-                if( g_mateForRow[ row ] == NO_SUCH_THING )
+                row = m_rccForCol[ col ][ i ].row;
+                if( m_mateForRow[ row ] == NO_SUCH_THING )
                 {
-                    g_mateForCol[ col ] = row;
+                    m_mateForCol[ col ] = row;
                     if( row >= 0 )
                     {
-                        g_mateForRow[ row ] = col;
+                        m_mateForRow[ row ] = col;
                     }
-                    g_solution[ g_solutionSize++ ] = g_rccForCol[ col ][ i ].tag;
+                    m_solution[ m_solutionSize++ ] = m_rccForCol[ col ][ i ].tag;
 
-                    search( level + 1, costSoFar + g_rccForCol[ col ][ i ].cost );
+                    search( level + 1, costSoFar + m_rccForCol[ col ][ i ].cost );
 
-                    g_solutionSize--;
-                    g_mateForRow[ row ] = NO_SUCH_THING;
-                    g_mateForCol[ col ] = NO_SUCH_THING;
+                    m_solutionSize--;
+                    m_mateForRow[ row ] = NO_SUCH_THING;
+                    m_mateForCol[ col ] = NO_SUCH_THING;
                 }
             }
     }
-    else if( costSoFar < g_bestSolutionCost )
+    else if( costSoFar < m_bestSolutionCost )
     {
-        for( i = 0; i < g_solutionSize; i++ )
+        for( i = 0; i < m_solutionSize; i++ )
         {
-            g_bestSolution[ i ] = g_solution[ i ];
+            m_bestSolution[ i ] = m_solution[ i ];
         }
-        g_bestSolutionSize = g_solutionSize;
-        g_bestSolutionCost = costSoFar;
+        m_bestSolutionSize = m_solutionSize;
+        m_bestSolutionCost = costSoFar;
     }
 }
 
-static double storeSolution( VECTOR_OF< void * > &tag, int *numTags )
+double BASSIGNMENT_SOLVER::storeSolution( VECTOR_OF< void * > &tag,
+                                          int *numTags )
 {
 
 
     int i;
 
-    tag.resize( g_bestSolutionSize - 1 );
-    for( i = 0; i < g_bestSolutionSize; i++ )
+    tag.resize( m_bestSolutionSize - 1 );
+    for( i = 0; i < m_bestSolutionSize; i++ )
     {
-        tag[ i ] = g_bestSolution[ i ];
+        tag[ i ] = m_bestSolution[ i ];
     }
-    *numTags = g_bestSolutionSize;
+    *numTags = m_bestSolutionSize;
 
-    return g_bestSolutionCost;
+    return m_bestSolutionCost;
 }
 
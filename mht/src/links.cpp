@@ -40,6 +40,10 @@
  *********************************************************************/
 
 #include "mht/links.h"
+#include "mht/pool.h"
+
+/* pool for the LINK_NODEs that don't fit inside their LINKS_TO<>s */
+static SLAB_POOL g_linkPool;
 
 /*-------------------------------------------------------------------*
  | XMakeLinkBase() -- basic routine for making a link between two
@@ -50,8 +54,8 @@ void XMakeLinkBase( void *obj0, LINKSbase &links0,
                     void *obj1, LINKSbase &links1 )
 {
     /* the following two nodes will be partners */
-    LINK_NODE *node0 = new LINK_NODE;
-    LINK_NODE *node1 = new LINK_NODE;
+    LINK_NODE *node0 = new( links0 ) LINK_NODE;
+    LINK_NODE *node1 = new( links1 ) LINK_NODE;
 
     links0.m_list.prepend( node0 );
     links1.m_list.prepend( node1 );
@@ -84,3 +88,71 @@ LINK_NODE::~LINK_NODE()
     }
 }
 
+
+/*-------------------------------------------------------------------*
+ | LINK_NODE::operator new() -- get memory for a LINK_NODE
+ |
+ | The version that's given a LINKS_TO<> uses one of its free slots,
+ | if it has any.  Otherwise the node comes from g_linkPool.
+ *-------------------------------------------------------------------*/
+
+void *LINK_NODE::operator new( size_t size )
+{
+
+
+    LINK_HEADER *header;
+
+    header = (LINK_HEADER *)SLAB_POOL::get( &g_linkPool,
+                                            sizeof( LINK_HEADER ) +
+                                            size );
+    header->info.isInline = 0;
+    header->info.inUse = 1;
+
+    return header + 1;
+}
+
+void *LINK_NODE::operator new( size_t size, LINKSbase &links )
+{
+
+
+    void *node;
+
+    node = links.getFreeSlot();
+    if( node == 0 )
+    {
+        node = operator new( size );
+    }
+
+    return node;
+}
+
+/*-------------------------------------------------------------------*
+ | LINK_NODE::operator delete() -- free the memory of a LINK_NODE
+ *-------------------------------------------------------------------*/
+
+void LINK_NODE::operator delete( void *node )
+{
+
+
+    LINK_HEADER *header;
+
+    if( node == 0 )
+    {
+        return;
+    }
+
+    header = (LINK_HEADER *)node - 1;
+    if( header->info.isInline )
+    {
+        header->info.inUse = 0;
+    }
+    else
+    {
+        SLAB_POOL::put( header );
+    }
+}
+
+void LINK_NODE::operator delete( void *node, LINKSbase & )
+{
+    operator delete( node );
+}
@@ -181,6 +181,8 @@ void DLISTbase::Xsplice( DLISTbase &dlist )
 {
 
 
+    DLISTnode *node;
+
     if( dlist.isEmpty() )
     {
         return;
@@ -210,16 +212,27 @@ void DLISTbase::Xsplice( DLISTbase &dlist )
         m_vnode.m_prev = dlistTail;
     }
 
+    /* dlist's header still leads to the objects that were moved */
+    for( node = dlist.XgetHead(); node->isNode(); node = node->m_next )
+    {
+        node->m_listLength = &m_length;
+    }
+    m_length += dlist.m_length;
+
     dlist.m_vnode.Xreset();
+    dlist.m_length = 0;
 
     m_vnode.check();
 }
 
 /*-------------------------------------------------------------------*
- | DLISTbase::getLength() -- count the objects on the list
+ | DLISTbase::XcountLength() -- count the objects on the list
+ |
+ | The list keeps count of its objects, so this is only needed for
+ | checking the count (see getLength()).
  *-------------------------------------------------------------------*/
 
-int DLISTbase::getLength() const
+int DLISTbase::XcountLength() const
 {
 
 
@@ -41,52 +41,242 @@
  *********************************************************************/
 
 #include "mht/mdlmht.h"
+#include <thread>		// for std::thread
+
+/*-------------------------------------------------------------------*
+ | LEAF_CHUNK -- number of leaves that a thread takes at a time in
+ |               MDL_MHT::measureAndValidate()
+ *-------------------------------------------------------------------*/
+
+static const int LEAF_CHUNK = 64;
 
 /*-------------------------------------------------------------------*
  | MDL_MHT::measureAndValidate() -- collect reports of measurements
  |                                  and grow track trees
+ |
+ | Before any children are made for reports, each model is given all
+ | the active states that belong to it, along with all the new
+ | reports, and asked which reports might validate to each state (see
+ | MODEL::validate()).  makeChildrenFor() is only called for those
+ | pairs.  Leaves that have no state are given every report.
+ |
+ | The leaves are then grown in chunks of LEAF_CHUNK, in up to
+ | getNumThreads() threads (see growLeavesInThread()).  The children
+ | aren't installed until all the chunks are done, and then they're
+ | installed in order, so the result is the same as growing the
+ | leaves one after another.
  *-------------------------------------------------------------------*/
 
 void MDL_MHT::measureAndValidate(const std::list<REPORT*>& newReports)
 {
 
 
-    PTR_INTO_ptrDLIST_OF< T_HYPO > tHypoPtr;
-    MDL_T_HYPO *tHypo;
     PTR_INTO_iDLIST_OF< REPORT > reportPtr;
     MDL_REPORT *report;
     MDL_ROOT_T_HYPO *root;
+    PTR_INTO_ptrDLIST_OF< MODEL > modelPtr;
+    std::vector< MDL_REPORT * > reports;
+    std::vector< MDL_STATE * > states;
+    std::vector< int > leaf;             // leaf that each state is on
+    std::vector< int > valid;            // lists of reports that might
+                                         //   validate, ending with -1
+    std::vector< int > first;            // start of each leaf's list in
+                                         //   valid, or -1 if it has no
+                                         //   state
+    std::vector< std::vector< MDL_NEW_CHILD > > children;
+                                         // children made for each chunk
+                                         //   of leaves
+    std::vector< MDL_NEW_CHILD > rootChildren;
+    std::vector< std::thread > thread;
+    std::atomic< int > nextChunk( 0 );
+    MDL_STATE *state;
+    int numLeaves;
+    int numReports;
+    int numChunks;
+    int numThreads;
+    int i;
+    int j;
+    int k;
+
+    /* make sure the models put their new states in our pool (they're
+       added to m_modelList by the derived class, so this can't be
+       done when they're added) */
+    LOOP_DLIST( modelPtr, m_modelList )
+    {
+        (*modelPtr).setPool( getPool() );
+    }
 
     /* get reports of measurements */
     measure(newReports);
 
-    /* loop through all the active track hypotheses (leaves of the track
-       trees), making children for each one */
-    LOOP_DLIST( tHypoPtr, m_activeTHypoList )
+    LOOP_DLIST( reportPtr, m_newReportList )
+    {
+        reports.push_back( (MDL_REPORT *)reportPtr.get() );
+    }
+    numReports = (int)reports.size();
+    numLeaves = (int)m_activeTHypoList.size();
+
+    /* find out which reports might validate to each active state,
+       model by model */
+    first.assign( numLeaves, -1 );
+    LOOP_DLIST( modelPtr, m_modelList )
     {
-        tHypo = (MDL_T_HYPO *)tHypoPtr.get();
+        states.clear();
+        leaf.clear();
+        for( i = 0; i < numLeaves; i++ )
+        {
+            state = ((MDL_T_HYPO *)m_activeTHypoList[ i ])->getState();
+            if( state != 0 && state->getMdl() == modelPtr.get() )
+            {
+                states.push_back( state );
+                leaf.push_back( i );
+            }
+        }
+
+        if( states.empty() || numReports == 0 )
+        {
+            continue;
+        }
 
-        tHypo->makeDefaultChildren();
+        k = (int)valid.size();
+        (*modelPtr).validate( &states[ 0 ], (int)states.size(),
+                              &reports[ 0 ], numReports,
+                              valid );
 
-        LOOP_DLIST( reportPtr, m_newReportList )
+        for( i = 0; i < (int)leaf.size(); i++ )
         {
-            report = (MDL_REPORT *)reportPtr.get();
-            tHypo->makeChildrenFor( report );
+            first[ leaf[ i ] ] = k;
+            while( valid[ k++ ] != -1 )
+                ;
         }
     }
 
+    /* make children for all the active track hypotheses (leaves of
+       the track trees), a chunk at a time */
+    numChunks = (numLeaves + LEAF_CHUNK - 1) / LEAF_CHUNK;
+    children.resize( numChunks );
+
+    numThreads = getNumThreads();
+    if( numThreads > numChunks )
+    {
+        numThreads = numChunks;
+    }
+
+    for( i = 0; i < numThreads - 1; i++ )
+    {
+        thread.push_back( std::thread( &MDL_MHT::growLeavesInThread, this,
+                                       &nextChunk,
+                                       reports.data(), numReports,
+                                       valid.data(), first.data(),
+                                       children.data() ) );
+    }
+    growLeavesInThread( &nextChunk, reports.data(), numReports,
+                        valid.data(), first.data(), children.data() );
+
+    for( i = 0; i < (int)thread.size(); i++ )
+    {
+        thread[ i ].join();
+    }
+
+    /* put the children into the trees, in the same order as if the
+       leaves had been grown one after another */
+    for( i = 0; i < numChunks; i++ )
+    {
+        installChildren( children[ i ] );
+    }
+
     /* make a new track tree for each reported measurement */
-    LOOP_DLIST( reportPtr, m_newReportList )
+    for( j = 0; j < numReports; j++ )
     {
-        report = (MDL_REPORT *)reportPtr.get();
+        report = reports[ j ];
 
-        root = new MDL_ROOT_T_HYPO( this );
+        root = new( getPool() ) MDL_ROOT_T_HYPO( this );
         installTree( root, -1 );
-        root->makeDefaultChildren();
-        root->makeChildrenFor( report );
+        root->makeDefaultChildren( rootChildren );
+        root->makeChildrenFor( report, rootChildren );
+        installChildren( rootChildren );
     }
 }
 
+/*-------------------------------------------------------------------*
+ | MDL_MHT::growLeavesInThread() -- make children for chunks of the
+ |                                  active leaves
+ |
+ | Each call takes the next chunk that nobody has started, until
+ | there are none left, and puts the children for it in that chunk's
+ | own list.  Nothing is installed, and nothing outside the chunk's
+ | leaves and list is changed (except through the MODELs and the
+ | pool), so several calls can run at once.
+ *-------------------------------------------------------------------*/
+
+void MDL_MHT::growLeavesInThread( std::atomic< int > *nextChunk,
+                                  MDL_REPORT **reports, int numReports,
+                                  const int *valid, const int *first,
+                                  std::vector< MDL_NEW_CHILD > *children )
+{
+
+
+    MDL_T_HYPO *tHypo;
+    int numLeaves = (int)m_activeTHypoList.size();
+    int chunk;
+    int end;
+    int i;
+    int j;
+    int k;
+
+    while( (chunk = (*nextChunk)++) * LEAF_CHUNK < numLeaves )
+    {
+        end = (chunk + 1) * LEAF_CHUNK;
+        if( end > numLeaves )
+        {
+            end = numLeaves;
+        }
+
+        for( i = chunk * LEAF_CHUNK; i < end; i++ )
+        {
+            tHypo = (MDL_T_HYPO *)m_activeTHypoList[ i ];
+
+            tHypo->makeDefaultChildren( children[ chunk ] );
+
+            if( first[ i ] == -1 )
+            {
+                for( j = 0; j < numReports; j++ )
+                {
+                    tHypo->makeChildrenFor( reports[ j ],
+                                            children[ chunk ] );
+                }
+            }
+            else
+            {
+                for( k = first[ i ]; valid[ k ] != -1; k++ )
+                {
+                    tHypo->makeChildrenFor( reports[ valid[ k ] ],
+                                            children[ chunk ] );
+                }
+            }
+        }
+    }
+}
+
+/*-------------------------------------------------------------------*
+ | MDL_MHT::installChildren() -- install a list of new children in
+ |                               their parents' trees, and empty it
+ *-------------------------------------------------------------------*/
+
+void MDL_MHT::installChildren( std::vector< MDL_NEW_CHILD > &children )
+{
+
+
+    int i;
+
+    for( i = 0; i < (int)children.size(); i++ )
+    {
+        children[ i ].parent->installChild( children[ i ].child,
+                                            children[ i ].report );
+    }
+    children.clear();
+}
+
 /*-------------------------------------------------------------------*
  | MDL_ROOT_T_HYPO::makeDefaultChildren() -- make the default
  |                                           children of a ROOT node
@@ -94,11 +284,12 @@ void MDL_MHT::measureAndValidate(const std::list<REPORT*>& newReports)
  | This makes the children that are not linked to a report.
  *-------------------------------------------------------------------*/
 
-void MDL_ROOT_T_HYPO::makeDefaultChildren()
+void MDL_ROOT_T_HYPO::makeDefaultChildren(
+    std::vector< MDL_NEW_CHILD > &children )
 {
 
 
-    installChild( new MDL_DUMMY_T_HYPO( m_mdlMht ) );
+    addChild( children, new( getPool() ) MDL_DUMMY_T_HYPO( m_mdlMht ) );
 }
 
 /*-------------------------------------------------------------------*
@@ -107,7 +298,8 @@ void MDL_ROOT_T_HYPO::makeDefaultChildren()
  | This makes the children that ARE linked to a report.
  *-------------------------------------------------------------------*/
 
-void MDL_ROOT_T_HYPO::makeChildrenFor( MDL_REPORT *report )
+void MDL_ROOT_T_HYPO::makeChildrenFor( MDL_REPORT *report,
+                                       std::vector< MDL_NEW_CHILD > &children )
 {
 
 
@@ -117,7 +309,9 @@ void MDL_ROOT_T_HYPO::makeChildrenFor( MDL_REPORT *report )
     int numStartStates;
     int i;
 
-    installChild( new MDL_FALARM_T_HYPO( m_mdlMht, report ) );
+    addChild( children,
+              new( getPool() ) MDL_FALARM_T_HYPO( m_mdlMht, report ),
+              report );
 
     LOOP_DLIST( modelPtr, m_mdlMht->m_modelList )
     {
@@ -129,9 +323,10 @@ void MDL_ROOT_T_HYPO::makeChildrenFor( MDL_REPORT *report )
         {
             state = mdl->getNewState( i, 0, report );
             if( state != 0 )
-                installChild( new MDL_START_T_HYPO( m_mdlMht,
-                                                    state,
-                                                    report ) );
+                addChild( children,
+                          new( getPool() ) MDL_START_T_HYPO( m_mdlMht,
+                                                             state ),
+                          report );
         }
 
         mdl->endNewStates();
@@ -145,11 +340,13 @@ void MDL_ROOT_T_HYPO::makeChildrenFor( MDL_REPORT *report )
  | This makes the children that are not linked to a report.
  *-------------------------------------------------------------------*/
 
-void MDL_DUMMY_T_HYPO::makeDefaultChildren()
+void MDL_DUMMY_T_HYPO::makeDefaultChildren(
+    std::vector< MDL_NEW_CHILD > &children )
 {
 
 
-    installChild( new MDL_DUMMY_T_HYPO( m_mdlMht, m_logLikelihood ) );
+    addChild( children, new( getPool() ) MDL_DUMMY_T_HYPO( m_mdlMht,
+                                                            m_logLikelihood ) );
 }
 
 /*-------------------------------------------------------------------*
@@ -160,7 +357,8 @@ void MDL_DUMMY_T_HYPO::makeDefaultChildren()
  | This makes the children that are not linked to a report.
  *-------------------------------------------------------------------*/
 
-void MDL_CONTINUE_T_HYPO::makeDefaultChildren()
+void MDL_CONTINUE_T_HYPO::makeDefaultChildren(
+    std::vector< MDL_NEW_CHILD > &children )
 {
 
 
@@ -175,10 +373,11 @@ void MDL_CONTINUE_T_HYPO::makeDefaultChildren()
     int i;
 
     if( endLogLikelihood != -INFINITY )
-        installChild( new MDL_END_T_HYPO( m_mdlMht,
-                                          m_logLikelihood,
-                                          skipLogLikelihood,
-                                          endLogLikelihood ) );
+        addChild( children,
+                  new( getPool() ) MDL_END_T_HYPO( m_mdlMht,
+                                                   m_logLikelihood,
+                                                   skipLogLikelihood,
+                                                   endLogLikelihood ) );
 
     if( continueLogLikelihood != -INFINITY )
     {
@@ -188,11 +387,12 @@ void MDL_CONTINUE_T_HYPO::makeDefaultChildren()
         {
             state = mdl->getNewState( i, m_state, 0 );
             if( state != 0 )
-                installChild( new MDL_SKIP_T_HYPO( m_mdlMht,
-                                                   m_logLikelihood,
-                                                   continueLogLikelihood,
-                                                   skipLogLikelihood,
-                                                   state ) );
+                addChild( children,
+                          new( getPool() ) MDL_SKIP_T_HYPO( m_mdlMht,
+                                                            m_logLikelihood,
+                                                            continueLogLikelihood,
+                                                            skipLogLikelihood,
+                                                            state ) );
         }
 
         mdl->endNewStates();
@@ -206,7 +406,9 @@ void MDL_CONTINUE_T_HYPO::makeDefaultChildren()
  | This makes the children that ARE linked to a report.
  *-------------------------------------------------------------------*/
 
-void MDL_CONTINUE_T_HYPO::makeChildrenFor( MDL_REPORT *report )
+void MDL_CONTINUE_T_HYPO::makeChildrenFor(
+    MDL_REPORT *report,
+    std::vector< MDL_NEW_CHILD > &children )
 {
 
 
@@ -215,22 +417,77 @@ void MDL_CONTINUE_T_HYPO::makeChildrenFor( MDL_REPORT *report )
         mdl->getContinueLogLikelihood( m_state );
     double detectLogLikelihood =
         mdl->getDetectLogLikelihood( m_state );
+    double stateLogLikelihood;
     MDL_STATE *state;
     int numNewStates;
+    int isValid;
     int i;
 
     numNewStates = mdl->beginNewStates( m_state, report );
 
     for( i = 0; i < numNewStates; i++ )
     {
-        state = mdl->getNewState( i, m_state, report );
-        if( state != 0 )
-            installChild( new MDL_CONTINUE_T_HYPO( m_mdlMht,
-                                                   m_logLikelihood,
-                                                   continueLogLikelihood,
-                                                   detectLogLikelihood,
-                                                   state, report ) );
+        isValid = mdl->getNewStateLogLikelihood( i, m_state, report,
+                                                 &stateLogLikelihood );
+        if( isValid == -1 )
+        {
+            state = mdl->getNewState( i, m_state, report );
+            if( state != 0 )
+                addChild( children,
+                          new( getPool() ) MDL_CONTINUE_T_HYPO( m_mdlMht,
+                                                                m_logLikelihood,
+                                                                continueLogLikelihood,
+                                                                detectLogLikelihood,
+                                                                state ),
+                          report );
+        }
+        else if( isValid )
+        {
+            addChild( children,
+                      new( getPool() ) MDL_CONTINUE_T_HYPO( m_mdlMht,
+                                                            m_logLikelihood,
+                                                            continueLogLikelihood,
+                                                            detectLogLikelihood,
+                                                            stateLogLikelihood,
+                                                            i ),
+                      report );
+        }
     }
 
     mdl->endNewStates();
 }
+
+/*-------------------------------------------------------------------*
+ | MDL_CONTINUE_T_HYPO::keep() -- make the state estimate, if the
+ |                                MODEL put it off
+ |
+ | This is called once pruning has shown that the state will be
+ | needed (see MODEL::getNewStateLogLikelihood()).  The parent is
+ | still on the tree at that point, so its state is still there.
+ *-------------------------------------------------------------------*/
+
+void MDL_CONTINUE_T_HYPO::keep()
+{
+
+
+    MDL_STATE *parentState;
+    MDL_REPORT *report;
+    MODEL *mdl;
+
+    if( m_state != 0 )
+    {
+        return;
+    }
+
+    parentState = ((MDL_T_HYPO *)getParent())->getState();
+    report = (MDL_REPORT *)getReport();
+    mdl = parentState->getMdl();
+
+    mdl->beginNewStates( parentState, report );
+    m_state = mdl->getNewState( m_stateNum, parentState, report );
+    mdl->endNewStates();
+
+#ifdef TSTBUG
+    assert( m_state != 0 );
+#endif
+}
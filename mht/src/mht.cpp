@@ -45,6 +45,8 @@
 
 #include "mht/mht.h"
 #include <list>
+#include <vector>
+#include <unordered_map>
 
 /*-------------------------------------------------------------------*
  | MHT::scan() -- do an iteration of the mht algorithm
@@ -66,7 +68,7 @@ int MHT::scan()
         doDbgA();
     }
 
-    m_activeTHypoList.removeAll();
+    m_activeTHypoList.clear();
     importNewReports();
 
     if( m_tTreeList.isEmpty() )
@@ -125,6 +127,12 @@ void MHT::addReports(const std::list<REPORT*> &newReports)
  | This assigns a row number to each new REPORT, for use in making
  | assignment problems later on, and moves all the REPORTs from the
  | new report list to the old report list.
+ |
+ | It also notes which GROUPs the new REPORTs connect.  Since old
+ | REPORTs never get new T_HYPOs, only a new REPORT can connect two
+ | GROUPs, so these are the only GROUPs that might have to merge (see
+ | findGroupLabels()).  A new REPORT that doesn't connect GROUPs
+ | simply takes the group id of the trees that use it.
  *-------------------------------------------------------------------*/
 
 void MHT::importNewReports()
@@ -132,12 +140,39 @@ void MHT::importNewReports()
 
 
     PTR_INTO_iDLIST_OF< REPORT > reportPtr;
+    PTR_INTO_LINKS_TO< T_HYPO > tHypoPtr;
     int rowNum;
+    int groupId;
+    int isShared;
 
     rowNum = 0;
     LOOP_DLIST( reportPtr, m_newReportList )
     {
         (*reportPtr).setRowNum( rowNum++ );
+
+        groupId = 0;
+        isShared = 0;
+        LOOP_LINKS( tHypoPtr, (*reportPtr).m_tHypoLinks )
+        {
+            if( groupId == 0 )
+            {
+                groupId = (*tHypoPtr).getTree()->getGroupId();
+            }
+            else if( (*tHypoPtr).getTree()->getGroupId() != groupId )
+            {
+                isShared = 1;
+            }
+        }
+        (*reportPtr).setGroupId( groupId );
+
+        if( isShared )
+        {
+            LOOP_LINKS( tHypoPtr, (*reportPtr).m_tHypoLinks )
+            {
+                m_changedGroupIds.insert(
+                    (*tHypoPtr).getTree()->getGroupId() );
+            }
+        }
     }
 
     m_oldReportList.splice( m_newReportList );
@@ -171,59 +206,186 @@ void MHT::makeNewGroups()
  |   in Yaakov Bar-Shalom, Ed.
  |   Multitarget-Multisensor Tracking
  |
- | My (derived) algorithm proceeds in three steps:
+ | Two T_TREEs belong in the same GROUP if they refer to the same
+ | REPORT, so the GROUPs are the connected pieces of the graph that
+ | links each REPORT to the T_TREEs that refer to it.
+ |
+ | Between calls, every GROUP has its own group id, shared by all its
+ | T_TREEs and REPORTs (a new T_TREE is given a new id by
+ | installTree()).  Most GROUPs can't have changed since then: a GROUP
+ | can only have to merge if a new REPORT connects it to another one
+ | (see importNewReports()), and it can only have to split if it has
+ | more than one T_TREE.  So only those GROUPs are looked at, and
+ | they're put on m_changedGroups for splitGroups() and mergeGroups().
+ | All the others keep their group ids.
+ |
+ | The trees in the changed GROUPs are labeled with a disjoint-set
+ | forest (union-find, with union by size and path halving), in three
+ | steps:
  |
- | 1. All the T_TREE groupId members are initialized to -1, which
- |    indicates they haven't been grouped yet.
+ | 1. Every T_TREE in the changed GROUPs, and every REPORT that they
+ |    refer to, is numbered (the number is kept in its groupId member
+ |    for the moment), and put in a set by itself.
  |
- | 2. We loop through the list of all the old REPORTs, assigning each
- |    a group id by means of the member function setAllGroupIds().
- |    This function also gives the group id to all the T_TREEs that
- |    refer to the REPORT.  If a T_TREE has already been given a
- |    group id by a previous REPORT, then that report is also given
- |    the new id.
+ | 2. Each T_TREE's set is merged with the sets of all the REPORTs
+ |    that it refers to.
  |
- | 3. After step 2, all the T_TREEs that refer to any REPORT have
- |    been given group id's.  But there might be a few T_TREEs that
- |    don't refer to any REPORTs at all.  The last step is to give
- |    each of these T_TREEs a unique group id (since each of them can
- |    be in a GROUP by itself).
+ | 3. Each set is given a new group id, and every T_TREE and REPORT
+ |    is given the group id of its set.
+ |
+ | Since a REPORT that is used by a changed GROUP is only used by
+ | changed GROUPs, the sets are exactly the connected pieces of the
+ | graph.
  *-------------------------------------------------------------------*/
 
+static int findGroupRoot( VECTOR_OF< int > &parent, int node )
+{
+    while( parent[ node ] != node )
+    {
+        parent[ node ] = parent[ parent[ node ] ];
+        node = parent[ node ];
+    }
+    return node;
+}
+
 void MHT::findGroupLabels()
 {
 
 
-    PTR_INTO_iDLIST_OF< T_TREE > tTreePtr;
-    PTR_INTO_iDLIST_OF< REPORT > reportPtr;
-    int groupId;
+    PTR_INTO_iDLIST_OF< GROUP > groupPtr;
+    PTR_INTO_LINKS_TO< T_HYPO > tHypoPtr;
+    std::vector< T_TREE * > tree;
+    std::vector< REPORT * > report;
+    VECTOR_OF< int > parent;
+    VECTOR_OF< int > setSize;
+    VECTOR_OF< int > setGroupId;
+    T_HYPO *tHypo;
+    REPORT *nodeReport;
+    int tNode;
+    int numNodes;
+    int root0;
+    int root1;
+    int node;
+    int i;
 
-    LOOP_DLIST( tTreePtr, m_tTreeList )
+#ifdef TSTBUG
+    assert( m_newReportList.isEmpty() );
+    //  THROW_ERR( "m_newReportList must be empty in findGroupLabels()" )
+#endif
+
+    m_changedGroups.clear();
+    LOOP_DLIST( groupPtr, m_groupList )
     {
-        (*tTreePtr).setGroupId( -1 );
+        if( (*groupPtr).getNumTrees() > 1 ||
+                m_changedGroupIds.count( (*groupPtr).getGroupId() ) )
+        {
+            m_changedGroups.push_back( groupPtr.get() );
+        }
     }
+    m_changedGroupIds.clear();
 
-    groupId = 1;
+    /* step 1 -- T_TREEs are numbered from 0, REPORTs after them */
+    for( i = 0; i < (int)m_changedGroups.size(); i++ )
+    {
+        LOOP_LINKS( tHypoPtr,
+                    (*m_changedGroups[ i ]->m_gHypoList).m_tHypoLinks )
+        {
+            (*tHypoPtr).getTree()->setGroupId( (int)tree.size() );
+            tree.push_back( (*tHypoPtr).getTree() );
+        }
+    }
 
-    LOOP_DLIST( reportPtr, m_oldReportList )
+    for( i = 0; i < (int)tree.size(); i++ )
     {
-        (*reportPtr).setAllGroupIds( groupId++ );
+        LOOP_TTREE( tNode, tree[ i ] )
+        {
+            tHypo = tree[ i ]->getTHypo( tNode );
+            if( tHypo->hasReport() )
+            {
+                tHypo->getReport()->setGroupId( -1 );
+            }
+        }
     }
 
-    LOOP_DLIST( tTreePtr, m_tTreeList )
+    numNodes = (int)tree.size();
+    for( i = 0; i < (int)tree.size(); i++ )
     {
-        if( (*tTreePtr).getGroupId() == -1 )
+        LOOP_TTREE( tNode, tree[ i ] )
         {
-            (*tTreePtr).setGroupId( groupId++ );
+            tHypo = tree[ i ]->getTHypo( tNode );
+            if( tHypo->hasReport() &&
+                    tHypo->getReport()->m_groupId == -1 )
+            {
+                tHypo->getReport()->setGroupId( numNodes++ );
+                report.push_back( tHypo->getReport() );
+            }
         }
     }
 
-#ifdef TSTBUG
-    assert( m_newReportList.isEmpty() );
-    //  THROW_ERR( "m_newReportList must be empty in findGroupLabels()" )
-#endif
+    if( numNodes == 0 )
+    {
+        return;
+    }
+
+    parent.resize( numNodes - 1 );
+    setSize.resize( numNodes - 1 );
+    for( node = 0; node < numNodes; node++ )
+    {
+        parent[ node ] = node;
+        setSize[ node ] = 1;
+    }
+
+    /* step 2 */
+    for( i = 0; i < (int)tree.size(); i++ )
+    {
+        LOOP_TTREE( tNode, tree[ i ] )
+        {
+            tHypo = tree[ i ]->getTHypo( tNode );
+            if( ! tHypo->hasReport() )
+            {
+                continue;
+            }
+
+            nodeReport = tHypo->getReport();
+            root0 = findGroupRoot( parent, i );
+            root1 = findGroupRoot( parent, nodeReport->m_groupId );
+            if( root0 == root1 )
+            {
+                continue;
+            }
+
+            if( setSize[ root0 ] < setSize[ root1 ] )
+            {
+                node = root0;
+                root0 = root1;
+                root1 = node;
+            }
+            parent[ root1 ] = root0;
+            setSize[ root0 ] += setSize[ root1 ];
+        }
+    }
+
+    /* step 3 */
+    setGroupId.resize( numNodes - 1 );
+    for( node = 0; node < numNodes; node++ )
+        if( parent[ node ] == node )
+        {
+            setGroupId[ node ] = m_nextGroupId++;
+        }
+
+    for( i = 0; i < (int)report.size(); i++ )
+    {
+        report[ i ]->setGroupId(
+            setGroupId[ findGroupRoot( parent, report[ i ]->m_groupId ) ] );
+    }
+    for( i = 0; i < (int)tree.size(); i++ )
+    {
+        tree[ i ]->setGroupId( setGroupId[ findGroupRoot( parent, i ) ] );
+    }
 
 #ifdef DEBUG
+    PTR_INTO_iDLIST_OF< REPORT > reportPtr;
+
     LOOP_DLIST( reportPtr, m_oldReportList )
     {
         (*reportPtr).checkGroupIds();
@@ -234,18 +396,30 @@ void MHT::findGroupLabels()
 /*-------------------------------------------------------------------*
  | MHT::splitGroups() -- split GROUPs that can split
  |
- | The hard part of this is handled in GROUP::splitIfYouMust().
+ | Only the GROUPs found by findGroupLabels() can have to split.  The
+ | hard part of this is handled in GROUP::splitIfYouMust().  The
+ | pieces of each GROUP that splits are put onto m_changedGroups in
+ | its place, in the order they have on m_groupList, for
+ | mergeGroups().
  *-------------------------------------------------------------------*/
 
 void MHT::splitGroups()
 {
 
 
-    PTR_INTO_iDLIST_OF< GROUP > groupPtr;
+    std::vector< GROUP * > changedGroups;
+    GROUP *group;
+    int i;
 
-    LOOP_DLIST( groupPtr, m_groupList )
+    changedGroups.swap( m_changedGroups );
+    for( i = 0; i < (int)changedGroups.size(); i++ )
     {
-        (*groupPtr).splitIfYouMust();
+        for( group = changedGroups[ i ];
+                group != 0;
+                group = group->splitIfYouMust() )
+        {
+            m_changedGroups.push_back( group );
+        }
     }
 }
 
@@ -253,41 +427,56 @@ void MHT::splitGroups()
  | MHT::mergeGroups() -- merge GROUPs that must merge
  |
  | Two GROUPs must merge if they both contain T_TREEs with the same
- | group id.  This routine simply goes through the list of GROUPs
- | from head to tail, and, for each GROUP, searches the rest of the
- | list for a GROUP with the same group id.  When it finds one, it
- | merges the two GROUPs, removes the one it found, and continues
- | searching.
+ | group id.  Only the GROUPs on m_changedGroups can have new group
+ | ids, so this routine goes through that list from head to tail,
+ | using a hash table keyed on group id to collect all the GROUPs with
+ | each id.  Then the first GROUP with each id absorbs all the others
+ | at once (see GROUP::merge()), and they are removed.
  *-------------------------------------------------------------------*/
 
 void MHT::mergeGroups()
 {
 
 
-    PTR_INTO_iDLIST_OF< GROUP > groupPtr0;
-    PTR_INTO_iDLIST_OF< GROUP > groupPtr1;
-    int groupId;
+    std::unordered_map< int, int > bucketOfId;
+    std::vector< std::vector< GROUP * > > bucket;
+    int b, i;
 
-    LOOP_DLIST( groupPtr0, m_groupList )
+    for( i = 0; i < (int)m_changedGroups.size(); i++ )
     {
-        groupId = (*groupPtr0).getGroupId();
+        std::pair< std::unordered_map< int, int >::iterator, bool >
+            found = bucketOfId.insert(
+                        std::make_pair( m_changedGroups[ i ]->getGroupId(),
+                                        (int)bucket.size() ) );
 
-        for( groupPtr1 = groupPtr0, ++groupPtr1;
-                groupPtr1.isValid();
-                ++groupPtr1 )
-            if( (*groupPtr1).getGroupId() == groupId )
+        if( found.second )
+        {
+            bucket.push_back( std::vector< GROUP * >() );
+        }
+        bucket[ found.first->second ].push_back( m_changedGroups[ i ] );
+    }
+    m_changedGroups.clear();
+
+    for( b = 0; b < (int)bucket.size(); b++ )
+        if( bucket[ b ].size() > 1 )
+        {
+            bucket[ b ][ 0 ]->merge( &bucket[ b ][ 1 ],
+                                     (int)bucket[ b ].size() - 1,
+                                     m_logMinGHypoRatio,
+                                     m_maxGHypos );
+            for( i = 1; i < (int)bucket[ b ].size(); i++ )
             {
-                (*groupPtr0).merge( groupPtr1.get(),
-                                    m_logMinGHypoRatio,
-                                    m_maxGHypos );
-                groupPtr1.remove();
+                delete bucket[ b ][ i ];
             }
-    }
+        }
 }
 
 /*-------------------------------------------------------------------*
  | MHT::pruneAndHypothesize() -- prune track trees and create new
  |                               G_HYPOs for each GROUP
+ |
+ | With more than one thread, the GROUPs are handed to
+ | GROUP::pruneAndHypothesize() all at once.
  *-------------------------------------------------------------------*/
 
 void MHT::pruneAndHypothesize()
@@ -295,13 +484,33 @@ void MHT::pruneAndHypothesize()
 
 
     PTR_INTO_iDLIST_OF< GROUP > groupPtr;
+    VECTOR_OF< GROUP * > group;
+    int numGroups;
 
+    if( m_numThreads <= 1 )
+    {
+        LOOP_DLIST( groupPtr, m_groupList )
+        {
+            (*groupPtr).pruneAndHypothesize( m_maxDepth,
+                                             m_logMinGHypoRatio,
+                                             m_maxGHypos );
+        }
+        return;
+    }
+
+    numGroups = 0;
+    group.resize( m_groupList.getLength() );
     LOOP_DLIST( groupPtr, m_groupList )
     {
-        (*groupPtr).pruneAndHypothesize( m_maxDepth,
-                                         m_logMinGHypoRatio,
-                                         m_maxGHypos );
+        group[ numGroups++ ] = groupPtr.get();
     }
+
+    GROUP::pruneAndHypothesize( numGroups == 0 ? 0 : &group[ 0 ],
+                                numGroups,
+                                m_maxDepth,
+                                m_logMinGHypoRatio,
+                                m_maxGHypos,
+                                m_numThreads );
 }
 
 void MHT::clear()
@@ -327,6 +536,10 @@ void MHT::clear()
  | MHT::removeUnusedTHypos() -- remove the T_HYPOs that are not
  |                              referred to in any G_HYPO, or have
  |                              had all their children removed
+ |
+ | The leaves that are left are the new T_HYPOs that survived, so
+ | this is where they are told to keep().  This is also where each
+ | tree's node table is compacted, if pruning has left it sparse.
  *-------------------------------------------------------------------*/
 
 void MHT::removeUnusedTHypos()
@@ -334,17 +547,35 @@ void MHT::removeUnusedTHypos()
 
 
     PTR_INTO_iDLIST_OF< T_TREE > tTreePtr;
-    PTR_INTO_iTREE_OF< T_HYPO > tHypoPtr;
+    T_TREE *tTree;
+    int node;
+    int nextNode;
 
     LOOP_DLIST( tTreePtr, m_tTreeList )
     {
-        LOOP_TREEpostOrder( tHypoPtr, *(*tTreePtr).getTree() )
+        tTree = tTreePtr.get();
+        if( tTree->getFirstNode() == -1 )
         {
-            if( ! (*tHypoPtr).isInUse() )
+            continue;
+        }
+
+        for( node = tTree->getFirstLeaf( tTree->getFirstNode() );
+                node != -1;
+                node = nextNode )
+        {
+            nextNode = tTree->getPostOrderNext( node );
+            if( tTree->isLeaf( node ) &&
+                    tTree->getTHypo( node )->m_gHypoLinks.isEmpty() )
+            {
+                tTree->removeSubtree( node );
+            }
+            else if( tTree->isLeaf( node ) )
             {
-                tHypoPtr.removeSubtree();
+                tTree->getTHypo( node )->keep();
             }
         }
+
+        tTree->compactIfSparse();
     }
 }
 
@@ -374,7 +605,7 @@ void MHT::verifyTTreeRoots()
                 {
                     root->verify();
                 }
-                tTree->removeRoot();
+                (*tTreePtr).removeRoot();
 
                 root = tTree->getRoot();
             }
@@ -408,7 +639,7 @@ void MHT::verifyLastTTreeRoots()
                 {
                     root->verify();
                 }
-                tTree->removeRoot();
+                (*tTreePtr).removeRoot();
             }
 
         }
@@ -427,6 +658,10 @@ void MHT::verifyLastTTreeRoots()
  |    tree, and contain no nodes that must be verified (basically,
  |    the tree isn't really done yet, but the application doesn't
  |    care what happens with it, so it can be discarded).
+ |
+ | Each T_TREE keeps count of its nodes that must be verified and its
+ | leaves that don't end the track, so this doesn't have to look
+ | through the trees (see T_TREE::isInUse()).
  *-------------------------------------------------------------------*/
 
 void MHT::removeUnusedTTrees()
@@ -434,28 +669,10 @@ void MHT::removeUnusedTTrees()
 
 
     PTR_INTO_iDLIST_OF< T_TREE > tTreePtr;
-    iTREE_OF< T_HYPO > *tTree;
-    PTR_INTO_iTREE_OF< T_HYPO > tHypoPtr;
-    int treeIsInUse;
 
     LOOP_DLIST( tTreePtr, m_tTreeList )
     {
-        tTree = (*tTreePtr).getTree();
-        treeIsInUse = 0;
-
-        if( ! tTree->isEmpty() &&
-                ! tTree->getRoot()->endsTrack() )
-            LOOP_TREE( tHypoPtr, *tTree )
-        {
-            if( (*tHypoPtr).mustVerify() ||
-                    (tHypoPtr.isAtLeaf() && ! (*tHypoPtr).endsTrack()) )
-            {
-                treeIsInUse = 1;
-                break;
-            }
-        }
-
-        if( ! treeIsInUse )
+        if( ! (*tTreePtr).isInUse() )
         {
             tTreePtr.remove();
         }
@@ -501,6 +718,9 @@ void MHT::removeUnusedGroups()
 /*-------------------------------------------------------------------*
  | MHT::updateActiveTHypoList() -- build the list of T_HYPOs that are
  |                                 leaves of track trees
+ |
+ | Each T_TREE keeps its own list of leaves up to date, so this only
+ | has to copy them out, without looking at the rest of the trees.
  *-------------------------------------------------------------------*/
 
 void MHT::updateActiveTHypoList()
@@ -508,16 +728,20 @@ void MHT::updateActiveTHypoList()
 
 
     PTR_INTO_iDLIST_OF< T_TREE > tTreePtr;
-    PTR_INTO_iTREE_OF< T_HYPO > tHypoPtr;
+    T_TREE *tTree;
+    int leaf;
 
     LOOP_DLIST( tTreePtr, m_tTreeList )
     {
-        LOOP_TREE( tHypoPtr, *(*tTreePtr).getTree() )
+        tTree = tTreePtr.get();
+
+#ifdef TSTBUG
+        tTree->check();
+#endif
+
+        LOOP_TTREEleaves( leaf, tTree )
         {
-            if( tHypoPtr.isAtLeaf() )
-            {
-                m_activeTHypoList.append( *tHypoPtr );
-            }
+            m_activeTHypoList.push_back( tTree->getTHypo( leaf ) );
         }
     }
 }
@@ -559,11 +783,11 @@ void MHT::describe( int spaces )
 {
 
 
-    PTR_INTO_ptrDLIST_OF< T_HYPO > tHypoPtr;
     PTR_INTO_iDLIST_OF< GROUP > groupPtr;
     PTR_INTO_iDLIST_OF< REPORT > reportPtr;
     PTR_INTO_iDLIST_OF< T_TREE > tTreePtr;
     int k;
+    int i;
 
     Indent( spaces );
     std::cout << "MHT ";
@@ -586,7 +810,7 @@ void MHT::describe( int spaces )
     std::cout << "active tHypo's:";
     k = 0;
 
-    LOOP_DLIST( tHypoPtr, m_activeTHypoList )
+    for( i = 0; i < (int)m_activeTHypoList.size(); i++ )
     {
         if( k++ >= 3 )
         {
@@ -597,7 +821,7 @@ void MHT::describe( int spaces )
         }
 
         std::cout << " ";
-        (*tHypoPtr).print();
+        m_activeTHypoList[ i ]->print();
     }
     std::cout << std::endl;
 
@@ -652,7 +876,7 @@ void MHT::printStats( int spaces )
 
 
     int totalTTrees = m_tTreeList.getLength();
-    int totalTHypos = m_activeTHypoList.getLength();
+    int totalTHypos = (int)m_activeTHypoList.size();
     int totalGroups = m_groupList.getLength();
     int totalGHypos;
     int maxGHypos;
@@ -693,6 +917,9 @@ void MHT::printStats( int spaces )
     Indent( spaces );
     std::cout << "  max hypos in a group: "
               << maxGHypos << std::endl;
+    Indent( spaces );
+    std::cout << "  solves avoided:       "
+              << GROUP::getNumAvoidedSolves() << std::endl;
 }
 
 /*-------------------------------------------------------------------*
@@ -40,6 +40,12 @@
  *********************************************************************/
 
 #include <stdlib.h>
+#include <thread>		// for std::thread
+#include <atomic>		// for std::atomic<>
+#include <vector>		// for std::vector<>
+#include <memory>		// for std::unique_ptr<>
+#include <algorithm>		// for std::nth_element()
+#include <unordered_map>	// for std::unordered_multimap<>
 
 #include "mht/mht.h"
 #include "mht/apqueue.h"
@@ -47,16 +53,22 @@
 
 /*-------------------------------------------------------------------*
  | g_apqueue -- assignment priority queue for generating new G_HYPOs
+ |
+ | g_threadApqueue -- assignment priority queues for the extra threads
+ |                    used by GROUP::pruneAndHypothesize() when it is
+ |                    given several GROUPs at once (the calling thread
+ |                    uses g_apqueue)
  *-------------------------------------------------------------------*/
 
 static ASSIGNMENT_PQUEUE g_apqueue;
+static std::vector< std::unique_ptr< ASSIGNMENT_PQUEUE > > g_threadApqueue;
 
 /*-------------------------------------------------------------------*
  | Stuff used by GROUP::merge()
  |
  | Merge is more complicated than it might seem.
  |
- | Here's the way a simple algorithm would work:
+ | Here's the way a simple algorithm would work (for two GROUPs):
  |
  |   For each G_HYPO, A, in GROUP 0
  |     For each G_HYPO, B, in GROUP 1
@@ -73,143 +85,115 @@ static ASSIGNMENT_PQUEUE g_apqueue;
  | below m_minGHypoRatio or the total number of G_HYPOs has reached
  | m_maxGHypos.
  |
- | Here's the algorithm I use:
- |
- | 1. Make a list of the G_HYPOs in GROUP 0, sorted in decreasing
- |    order of likelihood
+ | Several GROUPs often have to be merged into one at the same time,
+ | so the algorithm works on any number, K, of GROUPs at once.  Each
+ | new G_HYPO is made from a "G_HYPO_TUPLE", which holds K indices,
+ | one into an array of G_HYPOs from each GROUP.  Here's the
+ | algorithm:
  |
- | 2. Make a list of the G_HYPOs in GROUP 1, sorted in decreasing
- |    order of likelihood
+ | 1. For each GROUP, make an array of its G_HYPOs, sorted in
+ |    decreasing order of likelihood.
  |
- | 3. Initialize a priority queue (see pqueue.H) with a "G_HYPO_PAIR"
- |    structure, which contains two indices, one into each of the
- |    two arrays of pointers to G_HYPOs.  This initial G_HYPO_PAIR
- |    has both indices set to 0.
+ | 2. Initialize a priority queue (see pqueue.H) with the
+ |    G_HYPO_TUPLE that has all its indices set to 0.  Since the
+ |    arrays are sorted, and the likelihood of the resulting G_HYPO
+ |    is the product of the likelihoods of the K G_HYPOs indicated,
+ |    this is the most likely tuple.
  |
- |    A G_HYPO_PAIR indicates two G_HYPOs that can be combined to
- |    make a new G_HYPO for the merged GROUP.  Since the two lists
- |    are sorted by likelihood, and the likelihood of the resulting
- |    G_HYPO will be the product of the likelihoods of the two
- |    G_HYPOs indicated, the initial G_HYPO_PAIR indicates the most
- |    likely pair.
- |
- | 4. While the priority queue is not empty, the likelihood ratio
+ | 3. While the priority queue is not empty, the likelihood ratio
  |    hasn't gone below m_minGHypoRatio, and the total number of new
  |    G_HYPOs made hasn't reached m_maxGHypos
  |
- |    4.1 Get the next G_HYPO_PAIR off the priority queue.  This will
- |        indicate the most likely G_HYPO remaining to be made.
+ |    3.1 Get the next G_HYPO_TUPLE off the priority queue.  This
+ |        will indicate the most likely G_HYPO remaining to be made.
+ |
+ |    3.2 Make the G_HYPO that the G_HYPO_TUPLE indicates.
  |
- |    4.2 Make the G_HYPO that the G_HYPO_PAIR indicates.
+ |    3.3 Put its successors onto the priority queue.  These are made
+ |        by incrementing one of its indices by 1 -- but only the
+ |        indices from the last non-zero one onward, and only if they
+ |        don't run off the end of their arrays.
  |
- |        Now, the next-most-likely G_HYPO after this one will be
- |        made by keeping one of the two G_HYPOs we just combined,
- |        and replacing the other with its successor in the array
- |        that it came from.  So ...
+ | Restricting the successors in step 3.3 means that each tuple has
+ | exactly one predecessor (the one made by decrementing its last
+ | non-zero index), so no tuple is ever put on the priority queue
+ | twice, and we don't need an array of flags to say which ones have
+ | been used.  The predecessor is always at least as likely as the
+ | tuple, so the tuples still come off the priority queue in
+ | decreasing order of likelihood.
  |
- |    4.3 If the G_HYPO_PAIR's index into array 0 (from GROUP 0)
- |        is less than the number of elements in array 0,
- |        4.3.1 Make a new G_HYPO_PAIR, in which the index for array
- |              0 is incremented by 1, and put it on the priority
- |              queue
- |    4.4 If the G_HYPO_PAIR's index into array 1 (from GROUP 1)
- |        is less than the number of elements in array 1,
- |        4.4.1 Make a new G_HYPO_PAIR, in which the index for array
- |              1 is incremented by 1, and put it on the priority
- |              queue
+ | With more than two GROUPs, the result is the same as merging the
+ | GROUPs pairwise, one after another, since no G_HYPO that is pruned
+ | away by a pairwise merge could have been among the best G_HYPOs of
+ | the whole merge.  But this makes each new G_HYPO only once.
  |
- | To reduce the number of G_HYPO_PAIRs put onto the priority queue,
- | and prevent the same pair from being generated more than once,
- | I use an array of flags to say whether a given pair has been used
- | or not.  The array has one flag for each possible pair.  The flag
- | is set to 1 as soon as the corresponding pair has been placed on
- | the priority queue.  If the flag is already 1, the pair is not
- | placed on the queue again.
+ | For the same reason, only a few of each GROUP's G_HYPOs can ever
+ | be used: those whose likelihood ratio to the best G_HYPO in their
+ | own GROUP hasn't gone below m_minGHypoRatio, and, of those, only
+ | the m_maxGHypos most likely.  So step 1 throws the rest away before
+ | sorting.  And a tuple whose likelihood ratio to the best tuple has
+ | gone below m_minGHypoRatio is never put on the priority queue, and
+ | the indices of a tuple are thrown away as soon as its successors
+ | have been made, so the memory used grows with the number of tuples
+ | actually waiting on the queue, rather than with m_maxGHypos
+ | squared.
  *-------------------------------------------------------------------*/
 
-/* g_gHypoArray0 and g_gHypoArray1 are the two arrays of pointers to
-   G_HYPOs being combined for GROUP::merge().
-
-   NOTE: The compiler I'm using has a problem with globals
-   that are referred to by objects that are placed in container
-   classes.  Since G_HYPO_PAIR refers to g_gHypoArray0 and
-   g_gHypoArray1, and G_HYPO_PAIR is used in the PQUEUE_OF<> container
-   class, the problem happens here.  The symptoms are:
-
-   1. If the global is declared static, then two separate instances
-      of it are allocated -- one that can be accessed by G_HYPO_PAIR,
-      and one that can be accessed by the rest of the program.
-
-   2. If the global is not static, then its constructor and destructor
-      are both called twice.
-
-   I've worked around this by using SAFE_GLOBAL().  See safeglobal.H.
-*/
-
-#ifdef COMPILER_IS_DEBUGGED
-static VECTOR_OF< G_HYPO * > g_gHypoArray0;
-static VECTOR_OF< G_HYPO * > g_gHypoArray1;
-#else
-#define GLOBAL
-SAFE_GLOBAL( VECTOR_OF< G_HYPO * >, g_gHypoArray0 )
-SAFE_GLOBAL( VECTOR_OF< G_HYPO * >, g_gHypoArray1 )
-#undef GLOBAL
-#endif
+/* g_gHypoArray holds the sorted arrays of pointers to G_HYPOs for all
+   the GROUPs being merged, one after another.  The array for GROUP j
+   starts at g_firstGHypo[ j ], and has g_numGHypos[ j ] elements. */
+static VECTOR_OF< G_HYPO * > g_gHypoArray;
+static VECTOR_OF< int > g_firstGHypo;
+static VECTOR_OF< int > g_numGHypos;
+
+/* g_tupleIndex holds the indices of the G_HYPO_TUPLEs on the priority
+   queue.  The indices of tuple t are in elements t * K through
+   t * K + K - 1.  g_freeTuple lists the values of t that are not in
+   use. */
+static std::vector< int > g_tupleIndex;
+static std::vector< int > g_freeTuple;
+
 #define KBEST
 #define NSCAN_BACK_PRUNING
 
-/* flags for pairs of G_HYPOs */
-static VECTOR_OF< char > g_gHypoPairUsed;
-
-/* structure indicating a pair of G_HYPOs */
-struct G_HYPO_PAIR
+/* structure indicating a tuple of G_HYPOs */
+struct G_HYPO_TUPLE
 {
-    int i0, i1;
-
-    G_HYPO_PAIR(): i0( 0 ), i1( 0 ) {}
-
-    G_HYPO_PAIR( int i0Arg, int i1Arg ):
-        i0( i0Arg ),
-        i1( i1Arg )
-    {
-    }
-
-    G_HYPO *getGHypo0() const
-    {
-        return g_gHypoArray0[ i0 ];
-    }
-    G_HYPO *getGHypo1() const
+    double logLikelihood;
+    int tuple;
+    int lastMoved;
+
+    G_HYPO_TUPLE(): logLikelihood( 0 ), tuple( 0 ), lastMoved( 0 ) {}
+
+    G_HYPO_TUPLE( double logLikelihoodArg,
+                  int tupleArg,
+                  int lastMovedArg ):
+        logLikelihood( logLikelihoodArg ),
+        tuple( tupleArg ),
+        lastMoved( lastMovedArg )
     {
-        return g_gHypoArray1[ i1 ];
     }
 
-    double getLogLikelihood() const
+    int operator<( const G_HYPO_TUPLE &that ) const
     {
-        return getGHypo0()->getLogLikelihood() +
-               getGHypo1()->getLogLikelihood();
+        return logLikelihood < that.logLikelihood;
     }
 
-    int operator<( const G_HYPO_PAIR &that ) const
+    int operator>( const G_HYPO_TUPLE &that ) const
     {
-        return getLogLikelihood() < that.getLogLikelihood();
-    }
-
-    int operator>( const G_HYPO_PAIR &that ) const
-    {
-        return getLogLikelihood() > that.getLogLikelihood();
+        return logLikelihood > that.logLikelihood;
     }
 };
 
 /*-------------------------------------------------------------------*
- | setupArray0() and setupArray1() -- routines to fill in
- |                                    g_gHypoArray0 and g_gHypoArray1
+ | setupArray() -- routine to fill in part of g_gHypoArray
  |
- | These routines perform steps 1 and 2 of the algorithm described
- | above.
+ | This performs step 1 of the algorithm described above, for one
+ | GROUP.  It returns the number of G_HYPOs that were kept.
  |
- | NOTE: compareGHypoPtrs(), which I'd really rather put after the
- | two setupArray routines, has to go first because of some weirdness
- | with the way the SGI compiler handles templates.
+ | NOTE: compareGHypoPtrs(), which I'd really rather put after
+ | setupArray(), has to go first because of some weirdness with the
+ | way the SGI compiler handles templates.
  *-------------------------------------------------------------------*/
 
 static int compareGHypoPtrs( const void *addr0, const void *addr1 )
@@ -233,153 +217,233 @@ static int compareGHypoPtrs( const void *addr0, const void *addr1 )
 #undef gHypo1
 }
 
-static void setupArray0( iDLIST_OF< G_HYPO > &gHypoList, int numGHypos )
+static bool gHypoIsMoreLikely( G_HYPO *gHypo0, G_HYPO *gHypo1 )
+{
+    return gHypo0->getLogLikelihood() > gHypo1->getLogLikelihood();
+}
+
+static int setupArray( iDLIST_OF< G_HYPO > &gHypoList,
+                       int firstGHypo,
+                       double logMinGHypoRatio,
+                       int maxGHypos )
 {
 
 
     int compareGHypoPtrs( const void *addr0, const void *addr1 );
 
     PTR_INTO_iDLIST_OF< G_HYPO > gHypoPtr;
-    int i;
-
-    g_gHypoArray0.resize( numGHypos );
+    double bestLogLikelihood;
+    int numGHypos;
 
-    i = 0;
+    bestLogLikelihood = -INFINITY;
     LOOP_DLIST( gHypoPtr, gHypoList )
     {
         (*gHypoPtr).recomputeLogLikelihood(); // make sure logLikelihood
         //   is up to date
-        g_gHypoArray0[ i++ ] = gHypoPtr.get();
+        if( (*gHypoPtr).getLogLikelihood() > bestLogLikelihood )
+        {
+            bestLogLikelihood = (*gHypoPtr).getLogLikelihood();
+        }
     }
 
-    qsort( &g_gHypoArray0[ 0 ],
-           numGHypos,
-           sizeof( G_HYPO * ),
-           compareGHypoPtrs );
-}
-
-static void setupArray1( iDLIST_OF< G_HYPO > &gHypoList, int numGHypos )
-{
-
-
-    int compareGHypoPtrs( const void *addr0, const void *addr1 );
-
-    PTR_INTO_iDLIST_OF< G_HYPO > gHypoPtr;
-    int i;
-
-    g_gHypoArray1.resize( numGHypos );
-
-    i = 0;
+    numGHypos = 0;
     LOOP_DLIST( gHypoPtr, gHypoList )
     {
-        (*gHypoPtr).recomputeLogLikelihood(); // make sure logLikelihood
-        //   is up to date
-        g_gHypoArray1[ i++ ] = gHypoPtr.get();
+        if( (*gHypoPtr).getLogLikelihood() - bestLogLikelihood >=
+                logMinGHypoRatio )
+        {
+            g_gHypoArray[ firstGHypo + numGHypos++ ] = gHypoPtr.get();
+        }
     }
 
-    qsort( &g_gHypoArray1[ 0 ],
+    if( numGHypos > maxGHypos )
+    {
+        std::nth_element( &g_gHypoArray[ firstGHypo ],
+                          &g_gHypoArray[ firstGHypo + maxGHypos ],
+                          &g_gHypoArray[ firstGHypo ] + numGHypos,
+                          gHypoIsMoreLikely );
+        numGHypos = maxGHypos;
+    }
+
+    qsort( &g_gHypoArray[ firstGHypo ],
            numGHypos,
            sizeof( G_HYPO * ),
            compareGHypoPtrs );
+
+    return numGHypos;
 }
 
 /*-------------------------------------------------------------------*
- | GROUP::merge() -- merge two GROUPs
+ | GROUP::merge() -- merge several GROUPs into this one
  |
- | See above for algorithm.
+ | See above for algorithm.  The GROUPs in src[] are left empty.
  *-------------------------------------------------------------------*/
 
-void GROUP::merge( GROUP *src,
+void GROUP::merge( GROUP **src,
+                   int numSrcs,
                    double logMinGHypoRatio,
                    int maxGHypos )
 {
 
 
-#define G_HYPO_PAIR_USED( g0, g1 ) \
-    g_gHypoPairUsed[ ((g0) * maxGHypos) + g1 ]
+#define GROUP_( j ) ((j) == 0 ? this : src[ (j) - 1 ])
+#define TUPLE_INDEX( t, j ) g_tupleIndex[ (t) * numGroups + (j) ]
+#define ARRAY_G_HYPO( j, index ) g_gHypoArray[ g_firstGHypo[ j ] + (index) ]
+#define TUPLE_G_HYPO( t, j ) ARRAY_G_HYPO( j, TUPLE_INDEX( t, j ) )
 
-    static PQUEUE_OF< G_HYPO_PAIR > pqueue;
-    G_HYPO_PAIR gHypoPair( 0, 0 );
+    static PQUEUE_OF< G_HYPO_TUPLE > pqueue;
+    G_HYPO_TUPLE gHypoTuple;
     G_HYPO *gHypo;
     double bestLogLikelihood;
-    int numGHypos0;
-    int numGHypos1;
+    double logLikelihood;
+    int numGroups;
+    int numTotalGHypos;
+    int newTuple;
     iDLIST_OF< G_HYPO > newGHypoList;
     PTR_INTO_iDLIST_OF< G_HYPO > gHypoPtr;
-    int i;
+    int i, j, k;
 
-    numGHypos1 = src->m_gHypoList.getLength();
-    numGHypos0 = m_gHypoList.getLength();
-    //CheckMem();
+    numGroups = numSrcs + 1;
 
-    if( numGHypos1 == 1 )
+    /* if each of the GROUPs being merged in has only one G_HYPO, its
+       T_HYPOs can simply be added to every one of our G_HYPOs */
+    for( j = 0; j < numSrcs; j++ )
+        if( src[ j ]->m_gHypoList.getLength() != 1 )
+        {
+            break;
+        }
+    if( j == numSrcs )
     {
-
         LOOP_DLIST( gHypoPtr, m_gHypoList )
         {
-            (*gHypoPtr).merge( src->m_gHypoList.getHead() );
-            //CheckMem();
+            for( j = 0; j < numSrcs; j++ )
+            {
+                (*gHypoPtr).merge( src[ j ]->m_gHypoList.getHead() );
+            }
+        }
+        for( j = 0; j < numSrcs; j++ )
+        {
+            src[ j ]->m_gHypoList.removeAll();
         }
-        src->m_gHypoList.removeAll();
 
         return;
     }
-    setupArray0( m_gHypoList, numGHypos0 );
-    setupArray1( src->m_gHypoList, numGHypos1 );
+
+    numTotalGHypos = 0;
+    for( j = 0; j < numGroups; j++ )
+    {
+        numTotalGHypos += GROUP_( j )->m_gHypoList.getLength();
+    }
+
+    g_firstGHypo.resize( numGroups - 1 );
+    g_numGHypos.resize( numGroups - 1 );
+    g_gHypoArray.resize( numTotalGHypos );
+    numTotalGHypos = 0;
+    for( j = 0; j < numGroups; j++ )
+    {
+        g_firstGHypo[ j ] = numTotalGHypos;
+        g_numGHypos[ j ] = setupArray( GROUP_( j )->m_gHypoList,
+                                       numTotalGHypos,
+                                       logMinGHypoRatio,
+                                       maxGHypos );
+        numTotalGHypos += g_numGHypos[ j ];
+    }
+
+    g_tupleIndex.resize( numGroups );
+    g_freeTuple.clear();
+
+    /* each tuple taken off the queue puts at most numGroups more on
+       it */
     pqueue.clear();
-    pqueue.resize( 2 * maxGHypos );
-    g_gHypoPairUsed.resize( 0, maxGHypos * maxGHypos );
-    g_gHypoPairUsed.clear();
-    bestLogLikelihood = gHypoPair.getLogLikelihood();
+    pqueue.resize( 1 + maxGHypos * numGroups );
+
+    bestLogLikelihood = 0;
+    for( j = 0; j < numGroups; j++ )
+    {
+        TUPLE_INDEX( 0, j ) = 0;
+        bestLogLikelihood += TUPLE_G_HYPO( 0, j )->getLogLikelihood();
+    }
+    gHypoTuple = G_HYPO_TUPLE( bestLogLikelihood, 0, 0 );
+
     i = 0;
     while( i < maxGHypos &&
-            gHypoPair.getLogLikelihood() - bestLogLikelihood >=
+            gHypoTuple.logLikelihood - bestLogLikelihood >=
             logMinGHypoRatio )
     {
         gHypo = new G_HYPO;
-        gHypo->merge( gHypoPair.getGHypo0() );
-        gHypo->merge( gHypoPair.getGHypo1() );
+        for( j = 0; j < numGroups; j++ )
+        {
+            gHypo->merge( TUPLE_G_HYPO( gHypoTuple.tuple, j ) );
+        }
         newGHypoList.append( gHypo );
-        //CheckMem();
-        if( gHypoPair.i0 + 1 < numGHypos0 &&
-                ! G_HYPO_PAIR_USED( gHypoPair.i0 + 1, gHypoPair.i1 ) )
+
+        if( ++i == maxGHypos )
         {
-            pqueue.put( G_HYPO_PAIR( gHypoPair.i0 + 1, gHypoPair.i1 ) );
-            G_HYPO_PAIR_USED( gHypoPair.i0 + 1, gHypoPair.i1 ) = 1;
+            break;
         }
-        if( gHypoPair.i1 + 1 < numGHypos1 &&
-                ! G_HYPO_PAIR_USED( gHypoPair.i0, gHypoPair.i1 + 1 ) )
+
+        for( j = gHypoTuple.lastMoved; j < numGroups; j++ )
         {
-            pqueue.put( G_HYPO_PAIR( gHypoPair.i0, gHypoPair.i1 + 1 ) );
-            G_HYPO_PAIR_USED( gHypoPair.i0, gHypoPair.i1 + 1 ) = 1;
+            if( TUPLE_INDEX( gHypoTuple.tuple, j ) + 1 >= g_numGHypos[ j ] )
+            {
+                continue;
+            }
+
+            logLikelihood = 0;
+            for( k = 0; k < numGroups; k++ )
+            {
+                logLikelihood +=
+                    ARRAY_G_HYPO( k, TUPLE_INDEX( gHypoTuple.tuple, k ) +
+                                     (k == j) )->getLogLikelihood();
+            }
+            if( logLikelihood - bestLogLikelihood < logMinGHypoRatio )
+            {
+                continue;
+            }
+
+            if( ! g_freeTuple.empty() )
+            {
+                newTuple = g_freeTuple.back();
+                g_freeTuple.pop_back();
+            }
+            else
+            {
+                newTuple = (int)g_tupleIndex.size() / numGroups;
+                g_tupleIndex.resize( g_tupleIndex.size() + numGroups );
+            }
+
+            for( k = 0; k < numGroups; k++ )
+            {
+                TUPLE_INDEX( newTuple, k ) =
+                    TUPLE_INDEX( gHypoTuple.tuple, k );
+            }
+            TUPLE_INDEX( newTuple, j )++;
+
+            pqueue.put( G_HYPO_TUPLE( logLikelihood, newTuple, j ) );
         }
+        g_freeTuple.push_back( gHypoTuple.tuple );
+
         if( ! pqueue.isEmpty() )
         {
-            gHypoPair = pqueue.get();
+            gHypoTuple = pqueue.get();
         }
         else
         {
             break;
         }
-
-        i++;
     }
 
-    /*
-      LOOP_LINKS( gHypoPtr, m_gHypoList )
-      {
-        (*gHypoPtr).describe( 2 );
-      }
-    */
-
     m_gHypoList.removeAll();
-    //CheckMem();
-
-    src->m_gHypoList.removeAll();
-    //CheckMem();
+    for( j = 0; j < numSrcs; j++ )
+    {
+        src[ j ]->m_gHypoList.removeAll();
+    }
     m_gHypoList.splice( newGHypoList );
 
-#undef G_HYPO_PAIR_USED
+#undef GROUP_
+#undef TUPLE_INDEX
+#undef ARRAY_G_HYPO
+#undef TUPLE_G_HYPO
 }
 
 /*-------------------------------------------------------------------*
@@ -405,18 +469,12 @@ void GROUP::merge( GROUP *src,
  |
  | All the trees in the new B have the same group id.  The trees in
  | B1 might have different group id's, so splitIfYouMust() should be
- | called for B1 next.  This happens automatically if splitIfYouMust()
- | is being called in a loop:
- |
- |   LOOP_DLIST( groupPtr, m_groupList )
- |   {
- |     (*groupPtr).splitIfYouMust();
- |   }
+ | called for B1 next.  To make this easy, splitIfYouMust() returns
+ | the new GROUP (or 0 if the GROUP wasn't split), so it can be called
+ | in a loop:
  |
- | When groupPtr points to B, B is split into the new B and B1.
- | groupPtr still points to B, so in the next iteration of the loop
- | it will be moved to B's successor, which is now B1, and
- | splitIfYouMust() will be called for B1.
+ |   for( group = B; group != 0; group = group->splitIfYouMust() )
+ |     ;
  |
  | The splitting itself simply requires splitting each G_HYPO
  | according to the group id that is to be kept in this GROUP.  This
@@ -430,7 +488,7 @@ void GROUP::merge( GROUP *src,
  | are removed by removeRepeats().
  *-------------------------------------------------------------------*/
 
-void GROUP::splitIfYouMust()
+GROUP *GROUP::splitIfYouMust()
 {
 
 
@@ -440,7 +498,7 @@ void GROUP::splitIfYouMust()
 
     if( m_gHypoList.isEmpty() || ! (*m_gHypoList).mustSplit() )
     {
-        return;
+        return 0;
     }
 
     newGroup = new GROUP();
@@ -456,49 +514,94 @@ void GROUP::splitIfYouMust()
 
     /* put the new group onto the list after this one */
     append( newGroup );
+
+    return newGroup;
 }
 
 /*-------------------------------------------------------------------*
  | GROUP::removeRepeats() -- remove identical G_HYPOs from the GROUP
  |
- | Each G_HYPO in the list is compared with all the G_HYPOs that come
- | after it.  All the ones that are identical to it are removed.
+ | When two G_HYPOs are identical, the less likely one is removed (or,
+ | if they're equally likely, the one that comes later on the list).
  | This means there will be no identical pairs of G_HYPOs left after
  | the routine is done.
  |
  | Here's the algorithm:
  |
- | 1. For each G_HYPO, A, on the list
- |    1.1 Flag all the T_HYPOs that are referred to in A
- |    1.2 For each G_HYPO, B, on the list after A
- |        1.2.1 Check to see if all the T_HYPOs referred to in B
- |              have been flagged.  If they all have, then A and B
- |              refer to exactly the same T_HYPOs, and are identical,
- |              so ...
- |              1.2.1.1 Remove B
- |    1.3 Unflag all the T_HYPOs that are referred to in A
+ | 1. For each G_HYPO, B, on the list
+ |    1.1 Look up B's signature (see G_HYPO::getSignature()) in a
+ |        hash table of the G_HYPOs kept so far
+ |    1.2 For each G_HYPO, A, found with the same signature and the
+ |        same number of T_HYPOs
+ |        1.2.1 Flag all the T_HYPOs that are referred to in A, and
+ |              check to see if all the T_HYPOs referred to in B have
+ |              been flagged.  If they all have, then A and B refer
+ |              to exactly the same T_HYPOs, and are identical, so
+ |              the less likely of the two is removed, and the other
+ |              is kept in the table
+ |        1.2.2 Unflag all the T_HYPOs that are referred to in A
+ |    1.3 If B wasn't identical to any of them, add it to the table
  *-------------------------------------------------------------------*/
 
 void GROUP::removeRepeats()
 {
 
 
-    PTR_INTO_iDLIST_OF< G_HYPO > gHypoPtr0;
-    PTR_INTO_iDLIST_OF< G_HYPO > gHypoPtr1;
+    typedef std::unordered_multimap< unsigned long, G_HYPO * > G_HYPO_TABLE;
 
-    LOOP_DLIST( gHypoPtr0, m_gHypoList )
+    PTR_INTO_iDLIST_OF< G_HYPO > gHypoPtr;
+    G_HYPO_TABLE table;
+    std::pair< G_HYPO_TABLE::iterator, G_HYPO_TABLE::iterator > range;
+    G_HYPO_TABLE::iterator entry;
+    unsigned long signature;
+    G_HYPO *gHypo;
+    int isRepeat;
+
+    if( m_gHypoList.getLength() < 2 )
+    {
+        return;
+    }
+
+    table.reserve( m_gHypoList.getLength() );
+
+    LOOP_DLIST( gHypoPtr, m_gHypoList )
     {
-        (*gHypoPtr0).setFlags();
+        signature = (*gHypoPtr).getSignature();
+        range = table.equal_range( signature );
+        isRepeat = 0;
 
-        for( gHypoPtr1 = gHypoPtr0, ++gHypoPtr1;
-                gHypoPtr1.isValid();
-                ++gHypoPtr1 )
-            if( (*gHypoPtr1).allFlagsAreSet() )
+        for( entry = range.first; entry != range.second; ++entry )
+        {
+            gHypo = entry->second;
+            if( gHypo->getNumTHypos() != (*gHypoPtr).getNumTHypos() )
             {
-                gHypoPtr1.remove();
+                continue;
             }
 
-        (*gHypoPtr0).resetFlags();
+            gHypo->setFlags();
+            isRepeat = (*gHypoPtr).allFlagsAreSet();
+            gHypo->resetFlags();
+
+            if( isRepeat )
+            {
+                break;
+            }
+        }
+
+        if( ! isRepeat )
+        {
+            table.insert( std::make_pair( signature, gHypoPtr.get() ) );
+        }
+        else if( (*gHypoPtr).getLogLikelihood() >
+                 gHypo->getLogLikelihood() )
+        {
+            entry->second = gHypoPtr.get();
+            delete gHypo;
+        }
+        else
+        {
+            gHypoPtr.remove();
+        }
     }
 }
 
@@ -506,13 +609,23 @@ void GROUP::removeRepeats()
  | GROUP::pruneAndHypothesize() -- prune the track trees and make new
  |                                 G_HYPOs
  |
- | The algorithm for this is described in mht.H.
+ | The algorithm for this is described in mht.H.  'apqueue' is the
+ | ASSIGNMENT_PQUEUE to use (it is emptied before and after).
  *-------------------------------------------------------------------*/
 
 void GROUP::pruneAndHypothesize( int maxDepth,
                                  double logMinGHypoRatio,
                                  int maxGHypos )
 {
+    pruneAndHypothesize( maxDepth, logMinGHypoRatio, maxGHypos,
+                         g_apqueue );
+}
+
+void GROUP::pruneAndHypothesize( int maxDepth,
+                                 double logMinGHypoRatio,
+                                 int maxGHypos,
+                                 ASSIGNMENT_PQUEUE &apqueue )
+{
 
 
     VECTOR_OF< void * > solution;
@@ -529,24 +642,24 @@ void GROUP::pruneAndHypothesize( int maxDepth,
     /* make an assignment problem for each G_HYPO, and put it on an
        assignment priority queue (see apqueue.H) */
 
-    g_apqueue.removeAllProblems();
+    apqueue.removeAllProblems();
 
     LOOP_DLIST( gHypoPtr, m_gHypoList )
     {
-        (*gHypoPtr).makeProblem();
+        (*gHypoPtr).makeProblem( apqueue );
     }
 
     /* if there are no possible assignments, do nothing (this GROUP is
        empty */
-    if( g_apqueue.isEmpty() )
+    if( apqueue.isEmpty() )
     {
         return;
     }
 
     /* get the best solution to an assignment problem */
 
-    bestCost = g_apqueue.getNextSolutionCost();
-    g_apqueue.getNextSolution( solution, &solutionSize );
+    bestCost = apqueue.getNextSolutionCost();
+    apqueue.getNextSolution( solution, &solutionSize );
 
 
     /* make a new G_HYPO based on the solution to the assignment
@@ -557,13 +670,17 @@ void GROUP::pruneAndHypothesize( int maxDepth,
     newGHypoList.append( m_bestGHypo );
     numNewGHypos = 1;
 
+    /* nothing costing more than this will be used, so the queue
+       needn't solve problems that it knows will cost more */
+    apqueue.setCostLimit( bestCost - logMinGHypoRatio );
+
     /* make the rest of the new G_HYPOs */
     while( numNewGHypos < maxGHypos &&
-            ! g_apqueue.isEmpty() &&
-            bestCost - g_apqueue.getNextSolutionCost() >=
+            ! apqueue.isEmpty() &&
+            bestCost - apqueue.getNextSolutionCost() >=
             logMinGHypoRatio )
     {
-        g_apqueue.getNextSolution( solution, &solutionSize );
+        apqueue.getNextSolution( solution, &solutionSize );
 
         newGHypo = new G_HYPO( solution, solutionSize );
         newGHypoList.append( newGHypo );
@@ -582,16 +699,170 @@ void GROUP::pruneAndHypothesize( int maxDepth,
     LOOP_DLIST( gHypoPtr, newGHypoList )
     if( (*gHypoPtr).wasReduced() )
     {
-        g_apqueue.removeProblem( gHypoPtr );
+        apqueue.removeProblem( gHypoPtr );
         gHypoPtr.remove();
     }
 
 
-    /* replace the old G_HYPOs with the new ones */
+    /* replace the old G_HYPOs with the new ones (the problems made
+       from the old ones aren't needed anymore) */
+    apqueue.removeAllProblems();
     m_gHypoList.removeAll();
     m_gHypoList.splice( newGHypoList );
 }
 
+/*-------------------------------------------------------------------*
+ | GROUP::getNumAvoidedSolves() -- find out how many assignment
+ |                                 problems pruneAndHypothesize() has
+ |                                 been able to leave unsolved
+ *-------------------------------------------------------------------*/
+
+long GROUP::getNumAvoidedSolves()
+{
+    long numAvoidedSolves;
+    int i;
+
+    numAvoidedSolves = g_apqueue.getNumAvoidedSolves();
+    for( i = 0; i < (int)g_threadApqueue.size(); i++ )
+    {
+        numAvoidedSolves += g_threadApqueue[ i ]->getNumAvoidedSolves();
+    }
+
+    return numAvoidedSolves;
+}
+
+/*-------------------------------------------------------------------*
+ | GROUP::getProblemSize() -- estimate how much work
+ |                            pruneAndHypothesize() will be for this
+ |                            GROUP
+ |
+ | This is the number of G_HYPOs times the number of trees, which is
+ | the number of T_HYPOs whose children go into assignment problems.
+ *-------------------------------------------------------------------*/
+
+int GROUP::getProblemSize()
+{
+    if( m_gHypoList.isEmpty() )
+    {
+        return 0;
+    }
+
+    return m_gHypoList.getLength() *
+           (*m_gHypoList).m_tHypoLinks.getLength();
+}
+
+/*-------------------------------------------------------------------*
+ | GROUP::pruneAndHypothesize() -- prune the track trees and make new
+ |                                 G_HYPOs for several GROUPs at once
+ |
+ | The GROUPs are sorted by getProblemSize(), largest first, and
+ | handed out in that order to 'numThreads' threads (including the
+ | calling one) as each finishes its last GROUP.  Since GROUPs don't
+ | share anything that pruneAndHypothesize() changes, the results are
+ | the same as doing them one at a time.
+ *-------------------------------------------------------------------*/
+
+struct gSIZED_GROUP
+{
+    GROUP *group;
+    int size;                        // from getProblemSize()
+    int index;                       // position in the caller's array
+};
+
+static int compareGroupSizes( const void *addr0, const void *addr1 )
+{
+#define group0 (*(gSIZED_GROUP *)addr0)
+#define group1 (*(gSIZED_GROUP *)addr1)
+
+    if( group0.size > group1.size )
+    {
+        return -1;
+    }
+    if( group0.size < group1.size )
+    {
+        return 1;
+    }
+    return group0.index - group1.index;
+
+#undef group0
+#undef group1
+}
+
+static void pruneAndHypothesizeInThread( gSIZED_GROUP *sizedGroup,
+                                         int numGroups,
+                                         std::atomic< int > *nextGroup,
+                                         int maxDepth,
+                                         double logMinGHypoRatio,
+                                         int maxGHypos,
+                                         ASSIGNMENT_PQUEUE *apqueue )
+{
+    int groupNum;
+
+    while( (groupNum = (*nextGroup)++) < numGroups )
+    {
+        sizedGroup[ groupNum ].group->pruneAndHypothesize( maxDepth,
+                                                           logMinGHypoRatio,
+                                                           maxGHypos,
+                                                           *apqueue );
+    }
+}
+
+void GROUP::pruneAndHypothesize( GROUP **group,
+                                 int numGroups,
+                                 int maxDepth,
+                                 double logMinGHypoRatio,
+                                 int maxGHypos,
+                                 int numThreads )
+{
+    VECTOR_OF< gSIZED_GROUP > sizedGroup;
+    std::vector< std::thread > thread;
+    std::atomic< int > nextGroup( 0 );
+    int i;
+
+    if( numGroups == 0 )
+    {
+        return;
+    }
+
+    sizedGroup.resize( numGroups - 1 );
+    for( i = 0; i < numGroups; i++ )
+    {
+        sizedGroup[ i ].group = group[ i ];
+        sizedGroup[ i ].size = group[ i ]->getProblemSize();
+        sizedGroup[ i ].index = i;
+    }
+    qsort( (void *)&sizedGroup[ 0 ], numGroups, sizeof( sizedGroup[ 0 ] ),
+           compareGroupSizes );
+
+    if( numThreads > numGroups )
+    {
+        numThreads = numGroups;
+    }
+    while( (int)g_threadApqueue.size() < numThreads - 1 )
+    {
+        g_threadApqueue.push_back(
+            std::unique_ptr< ASSIGNMENT_PQUEUE >( new ASSIGNMENT_PQUEUE ) );
+    }
+
+    for( i = 0; i < numThreads - 1; i++ )
+    {
+        thread.push_back( std::thread( pruneAndHypothesizeInThread,
+                                       &sizedGroup[ 0 ], numGroups,
+                                       &nextGroup,
+                                       maxDepth, logMinGHypoRatio,
+                                       maxGHypos,
+                                       g_threadApqueue[ i ].get() ) );
+    }
+    pruneAndHypothesizeInThread( &sizedGroup[ 0 ], numGroups, &nextGroup,
+                                 maxDepth, logMinGHypoRatio, maxGHypos,
+                                 &g_apqueue );
+
+    for( i = 0; i < (int)thread.size(); i++ )
+    {
+        thread[ i ].join();
+    }
+}
+
 void GROUP::clear( int maxDepth)
 {
 
@@ -768,7 +1039,7 @@ G_HYPO::G_HYPO( VECTOR_OF< void * > &solution, int solutionSize ):
  | G_HYPO is just the negated cost of the solution.
  |
  | What makeProblem() does is to construct the assignment problem
- | for an old G_HYPO and put it on the ASSIGNMENT_PQUEUE.  The
+ | for an old G_HYPO and put it on 'apqueue'.  The
  | tag fields of the ROW_COL_COST structures (see assign.H)
  | are set to point to the T_HYPOs that they correspond to.  So,
  | to make a G_HYPO from a solution to one of these problems, we
@@ -782,12 +1053,14 @@ G_HYPO::G_HYPO( VECTOR_OF< void * > &solution, int solutionSize ):
  | through the loop).
  *-------------------------------------------------------------------*/
 
-void G_HYPO::makeProblem()
+void G_HYPO::makeProblem( ASSIGNMENT_PQUEUE &apqueue )
 {
 
 
     PTR_INTO_LINKS_TO< T_HYPO > tHypoPtr;
-    PTR_INTO_iTREE_OF< T_HYPO > childPtr;
+    T_TREE *tTree;
+    T_HYPO *child;
+    int childNode;
     VECTOR_OF< ROW_COL_COST > rcc;
     int numRCCs;
     int rccNum;
@@ -821,14 +1094,16 @@ void G_HYPO::makeProblem()
     colNum = 0;
     LOOP_LINKS( tHypoPtr, m_tHypoLinks )
     {
-        LOOP_TREEchildren( childPtr, tHypoPtr.get() )
+        tTree = (*tHypoPtr).getTree();
+        LOOP_TTREEchildren( childNode, tTree, (*tHypoPtr).m_nodeIndex )
         {
-            rcc[ rccNum++ ].set( (*childPtr).getRowNum(), colNum,
-                                 -(*childPtr).getLogLikelihood(),
-                                 childPtr.get() );
-            if( (*childPtr).getRowNum() > maxRow )
+            child = tTree->getTHypo( childNode );
+            rcc[ rccNum++ ].set( child->getRowNum(), colNum,
+                                 -child->getLogLikelihood(),
+                                 child );
+            if( child->getRowNum() > maxRow )
             {
-                maxRow = (*childPtr).getRowNum();
+                maxRow = child->getRowNum();
             }
         }
         colNum++;
@@ -837,7 +1112,7 @@ void G_HYPO::makeProblem()
     /* sort the ROW_COL_COST structures and put the problem on the
        ASSIGNMENT_PQUEUE */
     SortAssignmentProblem( &rcc[ 0 ], numRCCs );
-    g_apqueue.addProblem( this, &rcc[ 0 ], rccNum, maxRow + 1, colNum );
+    apqueue.addProblem( this, &rcc[ 0 ], rccNum, maxRow + 1, colNum );
 
     double problemCoverage = (double)numRCCs /
                              ((double)(maxRow + 2) * (colNum + 1) - 1.);
@@ -856,6 +1131,11 @@ void G_HYPO::makeProblem()
  |       Find the node in the path that is a child of the root.
  |       Prune away all the other children of the root, along with
  |       their descendants.
+ |
+ | The length of the path and the child of the root come from the
+ | levels and jump links in the tree's node table (see T_TREE), so the
+ | path is never actually traced.  (Roots are only removed when they
+ | have one child, so each tree has a single root here.)
  *-------------------------------------------------------------------*/
 
 void G_HYPO::nScanBackPrune( int maxDepth )
@@ -863,37 +1143,46 @@ void G_HYPO::nScanBackPrune( int maxDepth )
 
 
     PTR_INTO_LINKS_TO< T_HYPO > tHypoPtr;
-    PTR_INTO_iTREE_OF< T_HYPO > parentPtr;
-    PTR_INTO_iTREE_OF< T_HYPO > siblingPtr;
-    PTR_INTO_iTREE_OF< T_HYPO > tHypoToSave;
-    int depth;
+    T_TREE *tTree;
+    int parent;
+    int sibling;
+    int nextSibling;
+    int nodeToSave;
 
     LOOP_LINKS( tHypoPtr, m_tHypoLinks )
     {
-        if( (*tHypoPtr).isRoot() )
-        {
-            continue;
-        }
+        tTree = (*tHypoPtr).getTree();
+        nodeToSave = (*tHypoPtr).m_nodeIndex;
+        parent = tTree->getFirstNode();
 
-        depth = 1;
-
-        tHypoToSave = tHypoPtr.get();
+#ifdef TSTBUG
+        assert( tTree->m_node[ parent ].nextSibling == -1 );
+        //  THROW_ERR( "Track tree has more than one root" )
+#endif
 
-        for( parentPtr = tHypoPtr.get(), parentPtr.gotoParent();
-                ! parentPtr.isAtRoot();
-                tHypoToSave = parentPtr, parentPtr.gotoParent() )
-        {
-            depth++;
-        }
-        if( depth < maxDepth )
+        if( nodeToSave == parent ||
+            tTree->getDepth( nodeToSave ) < maxDepth )
         {
             continue;
         }
 
-        LOOP_TREEchildren( siblingPtr, parentPtr )
-        if( siblingPtr != tHypoToSave )
+        nodeToSave = tTree->getAncestor( nodeToSave,
+                                         tTree->m_node[ parent ].level + 1 );
+
+#ifdef TSTBUG
+        assert( tTree->m_node[ nodeToSave ].parent == parent );
+        //  THROW_ERR( "Jump links lead off the path to the root" )
+#endif
+
+        for( sibling = tTree->m_node[ parent ].firstChild;
+                sibling != -1;
+                sibling = nextSibling )
         {
-            siblingPtr.removeSubtree();
+            nextSibling = tTree->m_node[ sibling ].nextSibling;
+            if( sibling != nodeToSave )
+            {
+                tTree->removeSubtree( sibling );
+            }
         }
     }
 }
@@ -992,6 +1281,39 @@ void G_HYPO::merge( G_HYPO *src )
     }
 }
 
+/*-------------------------------------------------------------------*
+ | G_HYPO::getSignature() -- compute a hash of the set of T_HYPOs in
+ |                           the G_HYPO
+ |
+ | Each T_HYPO's address is scrambled, and the results are added up,
+ | so the signature doesn't depend on the order in which the T_HYPOs
+ | were linked to the G_HYPO.  Two identical G_HYPOs always have the
+ | same signature; two different ones almost never do.
+ *-------------------------------------------------------------------*/
+
+unsigned long G_HYPO::getSignature()
+{
+
+
+    PTR_INTO_LINKS_TO< T_HYPO > tHypoPtr;
+    unsigned long long signature;
+    unsigned long long x;
+
+    signature = 0;
+    LOOP_LINKS( tHypoPtr, m_tHypoLinks )
+    {
+        x = (unsigned long long)(size_t)tHypoPtr.get();
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ULL;
+        x ^= x >> 33;
+        signature += x;
+    }
+
+    return (unsigned long)signature;
+}
+
 /*-------------------------------------------------------------------*
  | G_HYPO::setFlags() -- set the flags of all the T_HYPOs in the
  |                       G_HYPO
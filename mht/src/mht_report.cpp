@@ -42,51 +42,6 @@
 
 #include "mht/mht.h"
 
-/*-------------------------------------------------------------------*
- | REPORT::setAllGroupIds() -- set the group id's of all the track
- |                             trees that use this REPORT
- |
- | This loops through each T_HYPO that is linked to the REPORT and
- | gets the track tree that it's on.  It then looks at the group id
- | of the tree.  If the group id has not yet been set, it simply sets
- | it.  If it has already been set to a different id, then that means
- | that the tree also contains a T_HYPO linked to another REPORT, and
- | all the trees linked to that REPORT have to be in the same group
- | as the trees linked to this REPORT.  So we search back in the list
- | of REPORTs, looking for those that have the tree's current group
- | id, and call setAllGroupIds() on them, recursively.
- *-------------------------------------------------------------------*/
-
-void REPORT::setAllGroupIds( int groupId )
-{
-
-    PTR_INTO_iDLIST_OF< REPORT > reportPtr;
-    PTR_INTO_LINKS_TO< T_HYPO > tHypoPtr;
-    T_TREE *tree;
-    int treeGroupId;
-
-    m_groupId = groupId;
-
-    LOOP_LINKS( tHypoPtr, m_tHypoLinks )
-    {
-        tree = (*tHypoPtr).getTree();
-        treeGroupId = tree->getGroupId();
-
-        if( treeGroupId != groupId )
-        {
-            tree->setGroupId( groupId );
-            if( treeGroupId != -1 )
-            {
-                for( (reportPtr = this),--reportPtr; reportPtr.isValid(); --reportPtr )
-                    if( (*reportPtr).m_groupId == treeGroupId )
-                    {
-                        (*reportPtr).setAllGroupIds( groupId );
-                    }
-            }
-        }
-    }
-}
-
 /*-------------------------------------------------------------------*
  | REPORT::checkGroupIds() -- diagnostic
  *-------------------------------------------------------------------*/
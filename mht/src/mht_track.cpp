@@ -140,3 +140,482 @@ void T_HYPO::describeTree( int spaces, int depth )
     }
 }
 
+
+/*-------------------------------------------------------------------*
+ | T_TREE::addChild() -- add a T_HYPO to the node table
+ |
+ | The T_HYPO becomes the first child of 'parent' (or the first node
+ | at the top of the tree, if 'parent' is -1), just as
+ | T_HYPO::installChild() puts it first in the iTREE_OF< T_HYPO >.
+ |
+ | The new node is a leaf.  If its parent was a leaf, the new node
+ | takes the parent's place on the list of leaves.  Otherwise, it goes
+ | just before the first leaf under its next sibling.
+ |
+ | A node added at the top of the tree is at level 0; any other node
+ | is one level below its parent.
+ *-------------------------------------------------------------------*/
+
+void T_TREE::addChild( int parent, T_HYPO *child )
+{
+
+
+    T_NODE node;
+    int prevLeaf;
+    int nextLeaf;
+
+    child->m_nodeIndex = (int)m_node.size();
+
+    node.tHypo = child;
+    node.parent = parent;
+    node.firstChild = -1;
+    node.numChildren = 0;
+    node.level = parent == -1 ? 0 : m_node[ parent ].level + 1;
+    if( parent == -1 )
+    {
+        node.nextSibling = m_firstRoot;
+        m_firstRoot = child->m_nodeIndex;
+
+        prevLeaf = -1;
+        nextLeaf = m_firstLeaf;
+    }
+    else if( m_node[ parent ].firstChild == -1 )
+    {
+        node.nextSibling = -1;
+        m_node[ parent ].firstChild = child->m_nodeIndex;
+        m_node[ parent ].numChildren++;
+
+        prevLeaf = m_node[ parent ].prevLeaf;
+        nextLeaf = m_node[ parent ].nextLeaf;
+    }
+    else
+    {
+        node.nextSibling = m_node[ parent ].firstChild;
+        m_node[ parent ].firstChild = child->m_nodeIndex;
+        m_node[ parent ].numChildren++;
+
+        nextLeaf = getFirstLeaf( node.nextSibling );
+        prevLeaf = m_node[ nextLeaf ].prevLeaf;
+    }
+
+    m_node.push_back( node );
+    setJump( child->m_nodeIndex );
+    insertLeaf( child->m_nodeIndex, prevLeaf, nextLeaf );
+
+    /* the parent may have just stopped being a leaf */
+    if( parent != -1 && m_node[ parent ].numChildren == 1 &&
+            ! m_node[ parent ].tHypo->endsTrack() )
+    {
+        m_numOpenLeaves--;
+    }
+    if( ! child->endsTrack() )
+    {
+        m_numOpenLeaves++;
+    }
+    if( child->mustVerify() )
+    {
+        m_numMustVerify++;
+    }
+}
+
+/*-------------------------------------------------------------------*
+ | T_TREE::setJump() -- set the jump link of a node
+ |
+ | The jump links are skew-binary: a node jumps either to its parent
+ | or, when its parent's jump and the jump after that cover the same
+ | number of levels, straight past both of them.  That way the jumps
+ | from any node cover 1, 3, 7, 15 ... levels, and getAncestor() never
+ | takes more than about 2 log(d) steps to climb d levels.  A node at
+ | the top of the tree jumps to itself.
+ |
+ | The node's parent (and the parent's jumps) must already be set.
+ | Nodes above the root may have been cleared, but their levels and
+ | jumps stay in the table until it is compacted, so the links that
+ | lead to them still work.
+ *-------------------------------------------------------------------*/
+
+void T_TREE::setJump( int node )
+{
+
+
+    int parent;
+    int jump;
+
+    parent = m_node[ node ].parent;
+    if( parent == -1 )
+    {
+        m_node[ node ].jump = node;
+        return;
+    }
+
+    jump = m_node[ parent ].jump;
+    if( m_node[ parent ].level - m_node[ jump ].level ==
+        m_node[ jump ].level - m_node[ m_node[ jump ].jump ].level )
+    {
+        m_node[ node ].jump = m_node[ jump ].jump;
+    }
+    else
+    {
+        m_node[ node ].jump = parent;
+    }
+}
+
+/*-------------------------------------------------------------------*
+ | T_TREE::insertLeaf() -- put a node on the list of leaves, between
+ |                         two others (either of which may be -1)
+ *-------------------------------------------------------------------*/
+
+void T_TREE::insertLeaf( int node, int prev, int next )
+{
+    m_node[ node ].prevLeaf = prev;
+    m_node[ node ].nextLeaf = next;
+
+    if( prev == -1 )
+    {
+        m_firstLeaf = node;
+    }
+    else
+    {
+        m_node[ prev ].nextLeaf = node;
+    }
+    if( next != -1 )
+    {
+        m_node[ next ].prevLeaf = node;
+    }
+}
+
+/*-------------------------------------------------------------------*
+ | T_TREE::linkLeaves() -- make the list of leaves from scratch
+ *-------------------------------------------------------------------*/
+
+void T_TREE::linkLeaves()
+{
+
+
+    int node;
+    int prev;
+
+    m_firstLeaf = -1;
+    prev = -1;
+    LOOP_TTREE( node, this )
+    {
+        if( isLeaf( node ) )
+        {
+            insertLeaf( node, prev, -1 );
+            prev = node;
+        }
+    }
+}
+
+/*-------------------------------------------------------------------*
+ | T_TREE::removeSubtree() -- remove a node and all its descendants
+ |
+ | The entries for the subtree are cleared in the node table, and
+ | the T_HYPOs are deleted from the iTREE_OF< T_HYPO >.  The leaves of
+ | the subtree come one after another on the list of leaves, so they
+ | are cut out of it in one piece.  If that leaves the parent without
+ | children, the parent takes their place.
+ *-------------------------------------------------------------------*/
+
+void T_TREE::removeSubtree( int node )
+{
+
+
+    PTR_INTO_iTREE_OF< T_HYPO > tHypoPtr = m_node[ node ].tHypo;
+    T_HYPO *tHypo;
+    int parent;
+    int *link;
+    int firstLeaf;
+    int lastLeaf;
+    int prevLeaf;
+    int nextLeaf;
+    int i;
+
+    parent = m_node[ node ].parent;
+    if( parent == -1 )
+    {
+        link = &m_firstRoot;
+    }
+    else
+    {
+        link = &m_node[ parent ].firstChild;
+        m_node[ parent ].numChildren--;
+    }
+    while( *link != node )
+    {
+        link = &m_node[ *link ].nextSibling;
+    }
+    *link = m_node[ node ].nextSibling;
+
+    firstLeaf = -1;
+    lastLeaf = -1;
+    i = node;
+    for( ;; )
+    {
+        tHypo = m_node[ i ].tHypo;
+        if( tHypo->mustVerify() )
+        {
+            m_numMustVerify--;
+        }
+        m_node[ i ].tHypo = 0;
+        m_numRemoved++;
+
+        if( m_node[ i ].firstChild != -1 )
+        {
+            i = m_node[ i ].firstChild;
+            continue;
+        }
+
+        if( ! tHypo->endsTrack() )
+        {
+            m_numOpenLeaves--;
+        }
+        if( firstLeaf == -1 )
+        {
+            firstLeaf = i;
+        }
+        lastLeaf = i;
+
+        while( i != node && m_node[ i ].nextSibling == -1 )
+        {
+            i = m_node[ i ].parent;
+        }
+        if( i == node )
+        {
+            break;
+        }
+        i = m_node[ i ].nextSibling;
+    }
+
+    prevLeaf = m_node[ firstLeaf ].prevLeaf;
+    nextLeaf = m_node[ lastLeaf ].nextLeaf;
+    if( prevLeaf == -1 )
+    {
+        m_firstLeaf = nextLeaf;
+    }
+    else
+    {
+        m_node[ prevLeaf ].nextLeaf = nextLeaf;
+    }
+    if( nextLeaf != -1 )
+    {
+        m_node[ nextLeaf ].prevLeaf = prevLeaf;
+    }
+
+    if( parent != -1 && m_node[ parent ].firstChild == -1 )
+    {
+        insertLeaf( parent, prevLeaf, nextLeaf );
+        if( ! m_node[ parent ].tHypo->endsTrack() )
+        {
+            m_numOpenLeaves++;
+        }
+    }
+
+    tHypoPtr.removeSubtree();
+}
+
+/*-------------------------------------------------------------------*
+ | T_TREE::removeRoot() -- remove the root of the tree
+ |
+ | As in TREEbase::removeRoot(), the children of the root are put at
+ | the end of the list of nodes at the top of the tree.  Usually the
+ | root is the only node at the top, so the list of leaves stays the
+ | same.
+ *-------------------------------------------------------------------*/
+
+void T_TREE::removeRoot()
+{
+
+
+    T_HYPO *tHypo;
+    int root;
+    int *link;
+    int i;
+
+    root = m_firstRoot;
+    tHypo = m_node[ root ].tHypo;
+    m_firstRoot = m_node[ root ].nextSibling;
+
+    if( m_node[ root ].firstChild == -1 )
+    {
+        m_firstLeaf = m_node[ root ].nextLeaf;
+        if( m_firstLeaf != -1 )
+        {
+            m_node[ m_firstLeaf ].prevLeaf = -1;
+        }
+        if( ! tHypo->endsTrack() )
+        {
+            m_numOpenLeaves--;
+        }
+    }
+    if( tHypo->mustVerify() )
+    {
+        m_numMustVerify--;
+    }
+
+    for( link = &m_firstRoot; *link != -1;
+            link = &m_node[ *link ].nextSibling )
+        ;
+    *link = m_node[ root ].firstChild;
+
+    for( i = m_node[ root ].firstChild; i != -1;
+            i = m_node[ i ].nextSibling )
+    {
+        m_node[ i ].parent = -1;
+    }
+
+    m_node[ root ].tHypo = 0;
+    m_numRemoved++;
+
+    /* if there were other nodes at the top, the leaves under the old
+       root now come after theirs */
+    if( m_node[ root ].firstChild != -1 &&
+            m_node[ root ].nextSibling != -1 )
+    {
+        linkLeaves();
+    }
+
+    m_tree.removeRoot();
+}
+
+/*-------------------------------------------------------------------*
+ | T_TREE::compact() -- squeeze the cleared entries out of the node
+ |                      table
+ |
+ | The nodes that are left are copied into a new table in pre-order,
+ | each one finding its parent's new index through the parent's
+ | T_HYPO (a parent always comes before its children).  Then the
+ | child and sibling links are made by going through the new table
+ | backwards, putting each node first among its siblings.  Last, the
+ | jump links are made again, since some of them may lead to nodes
+ | that are gone.
+ *-------------------------------------------------------------------*/
+
+void T_TREE::compact()
+{
+
+
+    std::vector< T_NODE > newNode;
+    T_NODE node;
+    int parent;
+    int i;
+
+    newNode.reserve( m_node.size() - m_numRemoved );
+
+    LOOP_TTREE( i, this )
+    {
+        node = m_node[ i ];
+        if( node.parent != -1 )
+        {
+            node.parent = m_node[ node.parent ].tHypo->m_nodeIndex;
+        }
+        node.firstChild = -1;
+        node.nextSibling = -1;
+
+        node.tHypo->m_nodeIndex = (int)newNode.size();
+        newNode.push_back( node );
+    }
+
+    m_firstRoot = -1;
+    for( i = (int)newNode.size() - 1; i >= 0; i-- )
+    {
+        parent = newNode[ i ].parent;
+        if( parent == -1 )
+        {
+            newNode[ i ].nextSibling = m_firstRoot;
+            m_firstRoot = i;
+        }
+        else
+        {
+            newNode[ i ].nextSibling = newNode[ parent ].firstChild;
+            newNode[ parent ].firstChild = i;
+        }
+    }
+
+    m_node.swap( newNode );
+    m_numRemoved = 0;
+
+    for( i = 0; i < (int)m_node.size(); i++ )
+    {
+        setJump( i );
+    }
+
+    linkLeaves();
+}
+
+/*-------------------------------------------------------------------*
+ | T_TREE::check() -- test that the node table matches the
+ |                    iTREE_OF< T_HYPO > (for debugging)
+ *-------------------------------------------------------------------*/
+
+void T_TREE::check()
+{
+
+
+    PTR_INTO_iTREE_OF< T_HYPO > tHypoPtr;
+    int node;
+    int leaf;
+    int numNodes;
+    int numMustVerify;
+    int numOpenLeaves;
+
+    leaf = getFirstLeafOnList();
+    LOOP_TTREE( node, this )
+    {
+        if( isLeaf( node ) )
+        {
+            assert( leaf == node );
+            //  THROW_ERR( "List of leaves is out of step with tree" )
+            leaf = getNextLeafOnList( leaf );
+        }
+    }
+    assert( leaf == -1 );
+    //  THROW_ERR( "List of leaves has nodes that aren't leaves" )
+
+    numMustVerify = 0;
+    numOpenLeaves = 0;
+    LOOP_TTREE( node, this )
+    {
+        if( m_node[ node ].tHypo->mustVerify() )
+        {
+            numMustVerify++;
+        }
+        if( isLeaf( node ) && ! m_node[ node ].tHypo->endsTrack() )
+        {
+            numOpenLeaves++;
+        }
+    }
+    assert( numMustVerify == m_numMustVerify );
+    //  THROW_ERR( "Wrong count of nodes that must be verified" )
+    assert( numOpenLeaves == m_numOpenLeaves );
+    //  THROW_ERR( "Wrong count of leaves that don't end the track" )
+
+    node = getFirstNode();
+    numNodes = 0;
+    LOOP_TREE( tHypoPtr, m_tree )
+    {
+        assert( node != -1 && m_node[ node ].tHypo == tHypoPtr.get() );
+        //  THROW_ERR( "Node table out of step with track tree" )
+        assert( (*tHypoPtr).m_nodeIndex == node );
+        //  THROW_ERR( "T_HYPO has the wrong node index" )
+        assert( m_node[ node ].numChildren ==
+                (*tHypoPtr).TREEnode::getNumChildren() );
+        //  THROW_ERR( "Wrong number of children in node table" )
+        if( m_node[ node ].parent != -1 )
+        {
+            assert( m_node[ node ].level ==
+                    m_node[ m_node[ node ].parent ].level + 1 );
+            //  THROW_ERR( "Wrong level in node table" )
+            assert( getAncestor( node, m_node[ node ].level - 1 ) ==
+                    m_node[ node ].parent );
+            //  THROW_ERR( "Jump links lead off the path to the root" )
+        }
+
+        node = getPreOrderNext( node );
+        numNodes++;
+    }
+    assert( node == -1 );
+    //  THROW_ERR( "Node table has nodes the track tree doesn't" )
+    assert( numNodes + m_numRemoved == (int)m_node.size() );
+    //  THROW_ERR( "Node table has lost entries" )
+}
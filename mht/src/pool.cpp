@@ -0,0 +1,158 @@
+/*********************************************************************
+ * FILE: pool.C                                                      *
+ *                                                                   *
+ * CONTENTS:                                                         *
+ *                                                                   *
+ *   Routines for slab pools.  See pool.H for details.               *
+ *                                                                   *
+ *********************************************************************/
+
+#include <new>
+#include "mht/pool.h"
+
+/*-------------------------------------------------------------------*
+ | SLAB_POOL::SLAB_POOL() -- constructor
+ *-------------------------------------------------------------------*/
+
+SLAB_POOL::SLAB_POOL():
+    m_slabs(),
+    m_slabTop( 0 ),
+    m_slabEnd( 0 ),
+    m_mutex()
+{
+    int i;
+
+    for( i = 0; i < NUM_SIZES; i++ )
+    {
+        m_freeList[ i ] = 0;
+    }
+}
+
+/*-------------------------------------------------------------------*
+ | SLAB_POOL::~SLAB_POOL() -- destructor
+ *-------------------------------------------------------------------*/
+
+SLAB_POOL::~SLAB_POOL()
+{
+    int i;
+
+    for( i = 0; i < (int)m_slabs.size(); i++ )
+    {
+        ::operator delete( m_slabs[ i ] );
+    }
+}
+
+/*-------------------------------------------------------------------*
+ | SLAB_POOL::get() -- get a block of memory
+ |
+ | The size of the block, including its header, is rounded up to a
+ | multiple of SIZE_STEP to find its size class.  Blocks too big for
+ | any size class, and blocks for a null pool, come from the global
+ | heap, with a header that says so.
+ *-------------------------------------------------------------------*/
+
+void *SLAB_POOL::get( SLAB_POOL *pool, size_t size )
+{
+
+
+    BLOCK_HEADER *header;
+    FREE_BLOCK *block;
+    int sizeClass;
+
+    size += sizeof( BLOCK_HEADER );
+    if( size < sizeof( FREE_BLOCK ) )
+    {
+        size = sizeof( FREE_BLOCK );
+    }
+    sizeClass = (int)((size + SIZE_STEP - 1) / SIZE_STEP) - 1;
+
+    if( pool == 0 || sizeClass >= NUM_SIZES )
+    {
+        header = (BLOCK_HEADER *)::operator new( size );
+        header->info.pool = 0;
+        header->info.sizeClass = -1;
+        return header + 1;
+    }
+
+    {
+        std::lock_guard< std::mutex > lock( pool->m_mutex );
+
+        block = pool->m_freeList[ sizeClass ];
+        if( block != 0 )
+        {
+            pool->m_freeList[ sizeClass ] = block->next;
+        }
+        else
+        {
+            block = pool->carve( sizeClass );
+        }
+    }
+
+    block->header.info.pool = pool;
+    block->header.info.sizeClass = sizeClass;
+    return &block->header + 1;
+}
+
+/*-------------------------------------------------------------------*
+ | SLAB_POOL::put() -- give back a block of memory
+ *-------------------------------------------------------------------*/
+
+void SLAB_POOL::put( void *addr )
+{
+
+
+    BLOCK_HEADER *header;
+    FREE_BLOCK *block;
+    SLAB_POOL *pool;
+    int sizeClass;
+
+    if( addr == 0 )
+    {
+        return;
+    }
+
+    header = (BLOCK_HEADER *)addr - 1;
+    pool = header->info.pool;
+
+    if( pool == 0 )
+    {
+        ::operator delete( header );
+        return;
+    }
+
+    sizeClass = header->info.sizeClass;
+    block = (FREE_BLOCK *)header;
+
+    std::lock_guard< std::mutex > lock( pool->m_mutex );
+
+    block->next = pool->m_freeList[ sizeClass ];
+    pool->m_freeList[ sizeClass ] = block;
+}
+
+/*-------------------------------------------------------------------*
+ | SLAB_POOL::carve() -- cut a new block out of the newest slab
+ |
+ | When the newest slab doesn't have room, a new one is allocated.
+ | Whatever was left of the old one is never used.  (The caller must
+ | hold m_mutex.)
+ *-------------------------------------------------------------------*/
+
+SLAB_POOL::FREE_BLOCK *SLAB_POOL::carve( int sizeClass )
+{
+
+
+    size_t size = (size_t)(sizeClass + 1) * SIZE_STEP;
+    char *block;
+
+    if( m_slabTop == 0 || (size_t)(m_slabEnd - m_slabTop) < size )
+    {
+        m_slabTop = (char *)::operator new( SLAB_SIZE );
+        m_slabEnd = m_slabTop + SLAB_SIZE;
+        m_slabs.push_back( m_slabTop );
+    }
+
+    block = m_slabTop;
+    m_slabTop += size;
+
+    return (FREE_BLOCK *)block;
+}
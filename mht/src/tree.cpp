@@ -315,6 +315,7 @@ void TREEbase::removeRoot()
 
 
     TREEnode *oldRoot;
+    TREEnode *node;
 
     checkNotEmpty();
 
@@ -327,7 +328,19 @@ void TREEbase::removeRoot()
     m_vnode.m_childList.splice( oldRoot->m_childList );
     delete oldRoot;
 
-    XgetRoot()->m_parent = &m_vnode;
+    /* every node now at the top of the tree (there may be none, if
+       the old root was a leaf) must point back at m_vnode */
+    if( ! isEmpty() )
+    {
+        for( node = XgetRoot(); ; node = node->XgetNextSibling() )
+        {
+            node->m_parent = &m_vnode;
+            if( node->isLastSibling() )
+            {
+                break;
+            }
+        }
+    }
 
     check();
 }
@@ -63,6 +63,12 @@
 #define CORR_COEFF
 
 #include <iostream>
+#include <vector>
+#include <string.h>		// for memcmp()
+#include <algorithm>
+#if defined( __AVX__ )
+#include <immintrin.h>
+#endif
 
 double EPSILON = 0.00000000000001;
 
@@ -145,75 +151,69 @@ static const double LOG_NORMFACTOR =
 
 
 /*-------------------------------------------------------------------*
- | CORNER_TRACK_STATE::setup() -- compute parts of Kalman filter
- |                           calculation that are independent of
- |                           reports
+ | CONSTVEL_COV::CONSTVEL_COV() -- compute parts of Kalman filter
+ |                                 calculation that are independent
+ |                                 of reports
  *-------------------------------------------------------------------*/
 
-void CONSTVEL_STATE::setup( double processVariance, const MATRIX &R )
+CONSTVEL_COV::CONSTVEL_COV( const fixedMATRIX< 4, 4 > &P,
+                            double processVariance,
+                            const fixedMATRIX< 2, 2 > &R ):
+    m_P( P ),
+    m_ds( 1 ),
+    m_F(),
+    m_logLikelihoodCoef( 0 ),
+    m_Sinv(),
+    m_W(),
+    m_nextP(),
+    m_next( 0 )
 {
 
 
-    /* don't do this more than once */
-    if( m_hasBeenSetup )
-    {
-        return;
-    }
-
-    m_ds = 1;
-
     /* compute the state transition matrix and process covariance matrix
        based on the above time step */
 
     double ds2 = m_ds * m_ds;
     double ds3 = ds2 * m_ds;
 
-    static MATRIX F( 4, 4 );
-    F.set(     1.,  m_ds,    0.,    0.,
+    m_F.set(   1.,  m_ds,    0.,    0.,
                0.,    1.,    0.,    0.,
                0.,    0.,    1.,  m_ds,
                0.,    0.,    0.,    1.    );
 
 
-    static MATRIX Q( 4, 4 );
+    fixedMATRIX< 4, 4 > Q;
     Q.set(  ds3/3, ds2/2,    0.,    0.,
             ds2/2,  m_ds,    0.,    0.,
             0.,    0., ds3/3, ds2/2,
             0.,    0., ds2/2,  m_ds  );
     Q = Q * processVariance;
 
-    static MATRIX H(2,4);
+    fixedMATRIX< 2, 4 > H;
     H.set(1., 0., 0., 0.,
           0., 0., 1., 0.);
 
 
     /* fill in the rest of the variables */
 
-    MATRIX P1 = F * m_P * F.trans() + Q; // state prediction covariance
+    fixedMATRIX< 4, 4 > P1 =             // state prediction covariance
+        m_F * m_P * m_F.trans() + Q;
 
-    MATRIX S = H * P1 * H.trans() + R;  // innovation covariance
+    fixedMATRIX< 2, 2 > S =              // innovation covariance
+        H * P1 * H.trans() + R;
 
     m_logLikelihoodCoef = -(LOG_NORMFACTOR + log( S.det() ) / 2);
 
-    m_Sinv = new MATRIX( S.inv() );
-//  printf("Sinv:\n"); m_Sinv->print();
+    m_Sinv = S.inv();
+//  printf("Sinv:\n"); m_Sinv.print();
 
-    m_W = new MATRIX( P1 * H.trans() * *m_Sinv );
+    m_W = P1 * H.trans() * m_Sinv;
 
-    MATRIX tmp(4,4);
-    tmp =  *m_W * S * m_W->trans();
-
-    MATRIX tmp1(4,4);
-    tmp1 = P1-tmp;
-
-    m_nextP = new MATRIX( tmp1 );
-    m_x1 = new MATRIX( F * m_x );
-
-    m_hasBeenSetup = 1;
+    m_nextP = P1 - m_W * S * m_W.trans();
 
 #ifdef DEBUG1
     printf("\nF:\n");
-    F.print();
+    m_F.print();
     printf("\nm_P:\n");
     m_P.print();
     printf("\nQ=\n");
@@ -223,15 +223,53 @@ void CONSTVEL_STATE::setup( double processVariance, const MATRIX &R )
     printf("\nInnov Cov(S=H*P1*H.trans):\n");
     S.print();
     printf("\nS_inv:\n");
-    m_Sinv->print();
-    printf("\nPrevious State:\n");
-    m_x.print();
+    m_Sinv.print();
     printf("LOG_NORMFACTOR =%lf log( S.det() ) / 2)=%lf\n",LOG_NORMFACTOR, log( S.det() ) / 2);
     printf(" m_logLikelihoodCoef= %lf\n", m_logLikelihoodCoef);
 #endif
 
 }
 
+/*-------------------------------------------------------------------*
+ | CONSTVEL_MDL::getNextCov() -- get the covariance for states one
+ |                               step older than the ones using cov
+ |
+ | The next link in the chain is made the first time it's asked for.
+ | If its covariance turns out to be exactly the same as cov's, then
+ | everything that follows from it would be the same too, so cov is
+ | used instead, and the chain stops growing.
+ *-------------------------------------------------------------------*/
+
+CONSTVEL_COV *CONSTVEL_MDL::getNextCov( CONSTVEL_COV *cov )
+{
+
+
+    CONSTVEL_COV *next;
+
+    next = cov->m_next.load( std::memory_order_acquire );
+    if( next != 0 )
+    {
+        return next;
+    }
+
+    std::lock_guard< std::mutex > lock( m_covMutex );
+
+    next = cov->m_next.load( std::memory_order_relaxed );
+    if( next == 0 )
+    {
+        next = new CONSTVEL_COV( cov->m_nextP, m_processVariance, m_R );
+        if( memcmp( next->m_P.getData(), cov->m_P.getData(),
+                    sizeof( cov->m_P ) ) == 0 )
+        {
+            delete next;
+            next = cov;
+        }
+        cov->m_next.store( next, std::memory_order_release );
+    }
+
+    return next;
+}
+
 /*--------------------------------------------*
  * CONSTVEL_MDL::getStateX(MDL_STATE *s)
  *--------------------------------------------*/
@@ -258,8 +296,7 @@ double CONSTVEL_MDL::getEndLogLikelihood( MDL_STATE *s )
     int m = cs->m_numSkipped;
     double endProb = 1.0 - exp( -m / m_lambda_x);
     endProb += (endProb == 0.0) ? EPSILON : 0.0;
-    m_endLogLikelihood = log( endProb);
-    return m_endLogLikelihood;
+    return log( endProb);
 }
 double CONSTVEL_MDL::getContinueLogLikelihood( MDL_STATE *s )
 {
@@ -267,8 +304,7 @@ double CONSTVEL_MDL::getContinueLogLikelihood( MDL_STATE *s )
     int m = cs->m_numSkipped;
     double endProb = 1.0 - exp( -m / m_lambda_x);
     endProb += (endProb == 0.0) ? EPSILON : 0.0;
-    m_continueLogLikelihood = log(1.0-endProb);
-    return m_continueLogLikelihood;
+    return log(1.0-endProb);
 }
 
 
@@ -299,22 +335,11 @@ MDL_STATE* CONSTVEL_MDL::getNewState( int stateNum,
 
     CONSTVEL_STATE *state = (CONSTVEL_STATE *) mdlState;
     CONSTPOS_REPORT *report = (CONSTPOS_REPORT *) mdlReport;
-    double dx,dy;
 
     switch(stateNum)
     {
     case 0:   // Continue constVel State
     {
-        if( state != 0 && report !=0 && state->getDX() == 0
-                && state->getDY() == 0 )
-        {
-            dx = report->getX() - state->getX();
-            dy = report->getY() - state->getY();
-
-            state->setDX(dx);
-            state->setDY(dy);
-        }
-
         CONSTVEL_STATE *newState;
         newState=getNextState(state,report);
         return (MDL_STATE*) newState;
@@ -337,13 +362,9 @@ CONSTVEL_STATE* CONSTVEL_MDL::getNextState( CONSTVEL_STATE *state,
         CONSTPOS_REPORT *report )
 {
     CONSTVEL_STATE *nextState;          // new state
-    static MATRIX v( 2,1 );              // innovation
+    fixedMATRIX< 2, 1 > v;              // innovation
     double distance;                   // mahalanobis distance
 
-    static MATRIX H(2,4);
-    H.set(1., 0., 0., 0.,
-          0., 0., 1., 0.);
-
 
     if( state == 0 )
     {
@@ -358,43 +379,39 @@ CONSTVEL_STATE* CONSTVEL_MDL::getNextState( CONSTVEL_STATE *state,
         printf("\nSTARTING NEW STATE WITH %lf %lf\n",x,y);
 #endif
 
-        nextState = new CONSTVEL_STATE( this,
-                                        x,
-                                        0.,
-                                        y,
-                                        0.,
-                                        m_startP,
-                                        m_startLogLikelihood,
-                                        0 );
+        nextState = new( getPool() ) CONSTVEL_STATE( this,
+                                                     x,
+                                                     0.,
+                                                     y,
+                                                     0.,
+                                                     m_startCov,
+                                                     m_startLogLikelihood,
+                                                     0 );
     }
     else if( report == 0 )
     {
         /* continuing an existing CORNER_TRACK, skipping a measurement */
 
-        state->setup( m_processVariance, m_R );
-
 #ifdef DEBUG1
         printf("Skipping meas(report=0); continued state= %lf %lf %lf %lf\n",
                state->getX1(), state->getDX1(),
                state->getY1(), state->getDY1() );
 #endif
 
-        nextState = new CONSTVEL_STATE( this,
-                                        state->getX1(),
-                                        state->getDX1(),
-                                        state->getY1(),
-                                        state->getDY1(),
-                                        state->getNextP(),
-                                        0.,
-                                        state->getNumSkipped() + 1 );
+        nextState = new( getPool() ) CONSTVEL_STATE( this,
+                                                     state->getX1(),
+                                                     state->getDX1(),
+                                                     state->getY1(),
+                                                     state->getDY1(),
+                                                     getNextCov( state->getCov() ),
+                                                     0.,
+                                                     state->getNumSkipped() + 1 );
     }
     else
     {
         /* continuing an existing CORNER_TRACK, with a measurement */
 
-        state->setup( m_processVariance, m_R );
-        v = report->getZ() - H * state->getPrediction();
-        distance = (v.trans() * state->getSinv() * v)();
+        distance = getDistance( state, report, v );
 #ifdef DEBUG1
         printf("\nPredicted State:\n");
         (state->getPrediction()).print(2);
@@ -413,22 +430,458 @@ CONSTVEL_STATE* CONSTVEL_MDL::getNextState( CONSTVEL_STATE *state,
         }
         else
         {
-            MATRIX new_m_x =  state->getPrediction() + state->getW() * v;
-
-            nextState = new CONSTVEL_STATE( this,
-                                            new_m_x(0),
-                                            new_m_x(1),
-                                            new_m_x(2),
-                                            new_m_x(3),
-                                            state->getNextP(),
-                                            state->getLogLikelihoodCoef() -
-                                            distance / 2,
-                                            0 );
+            fixedMATRIX< 4, 1 > new_m_x =
+                state->getPrediction() + state->getW() * v;
+
+            nextState = new( getPool() ) CONSTVEL_STATE( this,
+                                                         new_m_x(0),
+                                                         new_m_x(1),
+                                                         new_m_x(2),
+                                                         new_m_x(3),
+                                                         getNextCov( state->getCov() ),
+                                                         state->getLogLikelihoodCoef() -
+                                                         distance / 2,
+                                                         0 );
         }
     }
     return nextState;
 }
 
+/*-------------------------------------------------------------------*
+ | CONSTVEL_MDL::getNewStateLogLikelihood() -- get the likelihood of
+ |                                            the state getNewState()
+ |                                            would make
+ |
+ | Only the innovation and its mahalanobis distance are needed for
+ | this, so the posterior estimate and the CONSTVEL_STATE itself are
+ | only made for the few hypotheses that survive pruning.
+ *-------------------------------------------------------------------*/
+
+int CONSTVEL_MDL::getNewStateLogLikelihood( int stateNum,
+                                            MDL_STATE *mdlState,
+                                            MDL_REPORT *mdlReport,
+                                            double *logLikelihood )
+{
+
+
+    CONSTVEL_STATE *state = (CONSTVEL_STATE *) mdlState;
+    CONSTPOS_REPORT *report = (CONSTPOS_REPORT *) mdlReport;
+    fixedMATRIX< 2, 1 > v;              // innovation
+    double distance;                   // mahalanobis distance
+
+    assert( stateNum == 0 );
+
+    distance = getDistance( state, report, v );
+    if( distance > m_maxDistance )
+    {
+        return 0;
+    }
+
+    *logLikelihood = state->getLogLikelihoodCoef() - distance / 2;
+    return 1;
+}
+
+/*-------------------------------------------------------------------*
+ | CONSTVEL_MDL::getDistance() -- get the innovation of a report
+ |                                against a state's prediction, and
+ |                                its mahalanobis distance
+ *-------------------------------------------------------------------*/
+
+double CONSTVEL_MDL::getDistance( CONSTVEL_STATE *state,
+                                  CONSTPOS_REPORT *report,
+                                  fixedMATRIX< 2, 1 > &v )
+{
+
+
+    fixedMATRIX< 2, 4 > H;
+    H.set(1., 0., 0., 0.,
+          0., 0., 1., 0.);
+
+    v = report->getZ() - H * state->getPrediction();
+    return (v.trans() * state->getSinv() * v)();
+}
+
+
+
+/*-------------------------------------------------------------------*
+ | GATE_MARGIN -- how much to widen the bounding box of a gate, so
+ |                that rounding errors can't leave out a report that
+ |                is just inside it
+ *-------------------------------------------------------------------*/
+
+static const double GATE_MARGIN = 1.001;
+
+/*-------------------------------------------------------------------*
+ | gateCandidates() -- append to a list the candidate reports that
+ |                     are inside a state's gate
+ |
+ | cx and cy hold the positions of the candidates, and cand their
+ | indices.  The mahalanobis distances are computed for several
+ | candidates at a time, using AVX-512 or AVX when the compiler is
+ | allowed to.  The arithmetic is the same as in
+ | CONSTVEL_MDL::getNextState(), in the same order, so a report is
+ | left out here exactly when getNextState() would reject it (a NaN
+ | distance is let through, as it is there).
+ *-------------------------------------------------------------------*/
+
+static void gateCandidates( double px, double py,
+                            const fixedMATRIX< 2, 2 > &Sinv,
+                            double maxDistance,
+                            const double *cx, const double *cy,
+                            const int *cand, int numCand,
+                            std::vector< int > &valid )
+{
+
+
+    double s00 = Sinv( 0, 0 );
+    double s01 = Sinv( 0, 1 );
+    double s10 = Sinv( 1, 0 );
+    double s11 = Sinv( 1, 1 );
+    double v0, v1, t0, t1, d;
+    int i;
+
+    i = 0;
+
+#if defined( __AVX512F__ )
+    {
+        __m512d Px = _mm512_set1_pd( px );
+        __m512d Py = _mm512_set1_pd( py );
+        __m512d S00 = _mm512_set1_pd( s00 );
+        __m512d S01 = _mm512_set1_pd( s01 );
+        __m512d S10 = _mm512_set1_pd( s10 );
+        __m512d S11 = _mm512_set1_pd( s11 );
+        __m512d maxD = _mm512_set1_pd( maxDistance );
+        __m512d V0, V1, T0, T1, D;
+        __mmask8 tooFar;
+        int k;
+
+        for( ; i + 8 <= numCand; i += 8 )
+        {
+            V0 = _mm512_sub_pd( _mm512_loadu_pd( cx + i ), Px );
+            V1 = _mm512_sub_pd( _mm512_loadu_pd( cy + i ), Py );
+            T0 = _mm512_add_pd( _mm512_mul_pd( V0, S00 ),
+                                _mm512_mul_pd( V1, S10 ) );
+            T1 = _mm512_add_pd( _mm512_mul_pd( V0, S01 ),
+                                _mm512_mul_pd( V1, S11 ) );
+            D = _mm512_add_pd( _mm512_mul_pd( T0, V0 ),
+                               _mm512_mul_pd( T1, V1 ) );
+            tooFar = _mm512_cmp_pd_mask( D, maxD, _CMP_GT_OQ );
+
+            for( k = 0; k < 8; k++ )
+            {
+                if( ! ((tooFar >> k) & 1) )
+                {
+                    valid.push_back( cand[ i + k ] );
+                }
+            }
+        }
+    }
+#endif
+
+#if defined( __AVX__ )
+    {
+        __m256d Px = _mm256_set1_pd( px );
+        __m256d Py = _mm256_set1_pd( py );
+        __m256d S00 = _mm256_set1_pd( s00 );
+        __m256d S01 = _mm256_set1_pd( s01 );
+        __m256d S10 = _mm256_set1_pd( s10 );
+        __m256d S11 = _mm256_set1_pd( s11 );
+        __m256d maxD = _mm256_set1_pd( maxDistance );
+        __m256d V0, V1, T0, T1, D;
+        int tooFar;
+        int k;
+
+        for( ; i + 4 <= numCand; i += 4 )
+        {
+            V0 = _mm256_sub_pd( _mm256_loadu_pd( cx + i ), Px );
+            V1 = _mm256_sub_pd( _mm256_loadu_pd( cy + i ), Py );
+            T0 = _mm256_add_pd( _mm256_mul_pd( V0, S00 ),
+                                _mm256_mul_pd( V1, S10 ) );
+            T1 = _mm256_add_pd( _mm256_mul_pd( V0, S01 ),
+                                _mm256_mul_pd( V1, S11 ) );
+            D = _mm256_add_pd( _mm256_mul_pd( T0, V0 ),
+                               _mm256_mul_pd( T1, V1 ) );
+            tooFar = _mm256_movemask_pd(
+                         _mm256_cmp_pd( D, maxD, _CMP_GT_OQ ) );
+
+            for( k = 0; k < 4; k++ )
+            {
+                if( ! ((tooFar >> k) & 1) )
+                {
+                    valid.push_back( cand[ i + k ] );
+                }
+            }
+        }
+    }
+#endif
+
+    for( ; i < numCand; i++ )
+    {
+        v0 = cx[ i ] - px;
+        v1 = cy[ i ] - py;
+        t0 = v0 * s00 + v1 * s10;
+        t1 = v0 * s01 + v1 * s11;
+        d = t0 * v0 + t1 * v1;
+
+        if( ! (d > maxDistance) )
+        {
+            valid.push_back( cand[ i ] );
+        }
+    }
+}
+
+/*-------------------------------------------------------------------*
+ | CONSTVEL_MDL::validate() -- find the reports that might validate
+ |                             to each of the active states
+ |
+ | The reports are sorted into a uniform grid of cells, about the
+ | size of a typical gate.  Each state only looks at the cells that
+ | overlap the bounding box of its gate: the ellipse where the
+ | mahalanobis distance from the predicted measurement is no more
+ | than m_maxDistance, whose half-widths come from the diagonal of
+ | the innovation covariance.  So the work done here grows with the
+ | number of reports near each state, rather than with the number of
+ | reports.  Reports whose positions aren't finite numbers, and states
+ | whose gates can't be bounded, are tried against everything.
+ *-------------------------------------------------------------------*/
+
+void CONSTVEL_MDL::validate( MDL_STATE **mdlStates, int numStates,
+                             MDL_REPORT **mdlReports, int numReports,
+                             std::vector< int > &valid )
+{
+
+
+    CONSTVEL_STATE *state;
+    CONSTPOS_REPORT *report;
+    fixedMATRIX< 2, 4 > H;
+    fixedMATRIX< 2, 1 > Hx;
+    std::vector< double > rx( numReports );  // report positions
+    std::vector< double > ry( numReports );
+    std::vector< double > px( numStates );   // predicted measurements
+    std::vector< double > py( numStates );
+    std::vector< double > hw( numStates );   // half-width and half-
+    std::vector< double > hh( numStates );   //   height of each gate's
+                                             //   bounding box (-1 if
+                                             //   it has none)
+    std::vector< double > sizes;
+    std::vector< int > always;               // reports that aren't in
+                                             //   the grid
+    std::vector< int > cellStart;            // where each cell's
+                                             //   reports start in
+    std::vector< int > cellReports;          //   cellReports
+    std::vector< int > cand;                 // candidates for a state
+    std::vector< double > cx;                //   and their positions
+    std::vector< double > cy;
+    double minX = 0, maxX = 0, minY = 0, maxY = 0;
+    double a, b, c, det;
+    double cell;
+    double x0, x1, y0, y1;               // a gate's box, in cells
+    int numInGrid;
+    int numCols, numRows;
+    int col0, col1, row0, row1;
+    int i, j, k, col, row;
+
+    H.set(1., 0., 0., 0.,
+          0., 0., 1., 0.);
+
+    /* positions of the reports */
+    numInGrid = 0;
+    for( j = 0; j < numReports; j++ )
+    {
+        report = (CONSTPOS_REPORT *)mdlReports[ j ];
+        rx[ j ] = report->getZ()( 0 );
+        ry[ j ] = report->getZ()( 1 );
+
+        if( ! isfinite( rx[ j ] ) || ! isfinite( ry[ j ] ) )
+        {
+            always.push_back( j );
+            continue;
+        }
+
+        if( numInGrid++ == 0 )
+        {
+            minX = maxX = rx[ j ];
+            minY = maxY = ry[ j ];
+        }
+        minX = rx[ j ] < minX ? rx[ j ] : minX;
+        maxX = rx[ j ] > maxX ? rx[ j ] : maxX;
+        minY = ry[ j ] < minY ? ry[ j ] : minY;
+        maxY = ry[ j ] > maxY ? ry[ j ] : maxY;
+    }
+
+    /* predicted measurements and bounding boxes of the gates (the
+       box is bounded by the diagonal of S, the inverse of Sinv) */
+    for( i = 0; i < numStates; i++ )
+    {
+        state = (CONSTVEL_STATE *)mdlStates[ i ];
+
+        Hx = H * state->getPrediction();
+        px[ i ] = Hx( 0 );
+        py[ i ] = Hx( 1 );
+
+        const fixedMATRIX< 2, 2 > &Sinv = state->getSinv();
+        a = Sinv( 0, 0 );
+        b = (Sinv( 0, 1 ) + Sinv( 1, 0 )) / 2;
+        c = Sinv( 1, 1 );
+        det = a * c - b * b;
+
+        hw[ i ] = hh[ i ] = -1;
+        if( a > 0 && det > 0 && m_maxDistance >= 0 &&
+            isfinite( px[ i ] ) && isfinite( py[ i ] ) )
+        {
+            hw[ i ] = sqrt( m_maxDistance * c / det ) * GATE_MARGIN;
+            hh[ i ] = sqrt( m_maxDistance * a / det ) * GATE_MARGIN;
+            if( isfinite( hw[ i ] ) && isfinite( hh[ i ] ) )
+            {
+                sizes.push_back( 2 * (hw[ i ] > hh[ i ] ? hw[ i ]
+                                                        : hh[ i ]) );
+            }
+            else
+            {
+                hw[ i ] = hh[ i ] = -1;
+            }
+        }
+    }
+
+    /* sort the reports into the grid.  The cells are the size of the
+       median gate, but there are never many more cells than
+       reports. */
+    numCols = numRows = 1;
+    cell = 1;
+    if( numInGrid > 0 && ! sizes.empty() )
+    {
+        std::nth_element( sizes.begin(),
+                          sizes.begin() + sizes.size() / 2,
+                          sizes.end() );
+        cell = sizes[ sizes.size() / 2 ];
+        if( ! (cell > 0) )
+        {
+            cell = (maxX - minX > maxY - minY ? maxX - minX
+                                              : maxY - minY) /
+                   sqrt( (double)numInGrid );
+        }
+        if( ! (cell > 0) )
+        {
+            cell = 1;
+        }
+        while( ((maxX - minX) / cell + 1) * ((maxY - minY) / cell + 1) >
+               4. * numInGrid + 16 )
+        {
+            cell *= 2;
+        }
+        numCols = (int)((maxX - minX) / cell) + 1;
+        numRows = (int)((maxY - minY) / cell) + 1;
+    }
+
+    cellStart.assign( numCols * numRows + 1, 0 );
+    cellReports.resize( numInGrid );
+    for( k = 0; k < 2; k++ )
+    {
+        for( j = 0; j < numReports; j++ )
+        {
+            if( ! isfinite( rx[ j ] ) || ! isfinite( ry[ j ] ) )
+            {
+                continue;
+            }
+
+            col = (int)((rx[ j ] - minX) / cell);
+            row = (int)((ry[ j ] - minY) / cell);
+            col = col < numCols ? col : numCols - 1;
+            row = row < numRows ? row : numRows - 1;
+
+            if( k == 0 )
+            {
+                cellStart[ row * numCols + col + 1 ]++;
+            }
+            else
+            {
+                cellReports[ cellStart[ row * numCols + col ]++ ] = j;
+            }
+        }
+
+        /* after counting, turn the counts into starting points;
+           after filling, each cell's start has moved up to the next
+           cell's, so shift them back */
+        if( k == 0 )
+        {
+            for( i = 0; i < numCols * numRows; i++ )
+            {
+                cellStart[ i + 1 ] += cellStart[ i ];
+            }
+        }
+        else
+        {
+            for( i = numCols * numRows; i > 0; i-- )
+            {
+                cellStart[ i ] = cellStart[ i - 1 ];
+            }
+            cellStart[ 0 ] = 0;
+        }
+    }
+
+    /* gate each state against the reports near it */
+    for( i = 0; i < numStates; i++ )
+    {
+        cand.clear();
+
+        if( hw[ i ] < 0 )
+        {
+            for( j = 0; j < numReports; j++ )
+            {
+                cand.push_back( j );
+            }
+        }
+        else
+        {
+            if( numInGrid > 0 &&
+                px[ i ] + hw[ i ] >= minX && px[ i ] - hw[ i ] <= maxX &&
+                py[ i ] + hh[ i ] >= minY && py[ i ] - hh[ i ] <= maxY )
+            {
+                /* clamp before converting to int, so that a gate much
+                   wider than the grid can't overflow */
+                x0 = (px[ i ] - hw[ i ] - minX) / cell;
+                x1 = (px[ i ] + hw[ i ] - minX) / cell;
+                y0 = (py[ i ] - hh[ i ] - minY) / cell;
+                y1 = (py[ i ] + hh[ i ] - minY) / cell;
+                col0 = x0 > 0 ? (int)x0 : 0;
+                row0 = y0 > 0 ? (int)y0 : 0;
+                col1 = x1 < numCols - 1 ? (int)x1 : numCols - 1;
+                row1 = y1 < numRows - 1 ? (int)y1 : numRows - 1;
+
+                for( row = row0; row <= row1; row++ )
+                    for( col = col0; col <= col1; col++ )
+                    {
+                        k = row * numCols + col;
+                        cand.insert( cand.end(),
+                                     &cellReports[ 0 ] + cellStart[ k ],
+                                     &cellReports[ 0 ] +
+                                     cellStart[ k + 1 ] );
+                    }
+            }
+
+            cand.insert( cand.end(), always.begin(), always.end() );
+            std::sort( cand.begin(), cand.end() );
+        }
+
+        cx.resize( cand.size() );
+        cy.resize( cand.size() );
+        for( k = 0; k < (int)cand.size(); k++ )
+        {
+            cx[ k ] = rx[ cand[ k ] ];
+            cy[ k ] = ry[ cand[ k ] ];
+        }
+
+        if( ! cand.empty() )
+        {
+            state = (CONSTVEL_STATE *)mdlStates[ i ];
+            gateCandidates( px[ i ], py[ i ], state->getSinv(),
+                            m_maxDistance, &cx[ 0 ], &cy[ 0 ],
+                            &cand[ 0 ], (int)cand.size(), valid );
+        }
+        valid.push_back( -1 );
+    }
+}
+
 
 
 /*-------------------------------------------------------------------*
@@ -475,8 +928,10 @@ CONSTVEL_MDL::CONSTVEL_MDL( double positionMeasureVarianceX,
     m_processVariance( processVariance ),
     m_intensityVariance( intensityVariance ),
     m_stateVariance( stateVar ),
-    m_R( 2, 2 ),
-    m_startP( 4, 4 )
+    m_R(),
+    m_startP(),
+    m_startCov( 0 ),
+    m_covMutex()
 {
 
     std::cout << "\nSTARTING A NEW CONSTVEL_MDL\n";
@@ -484,7 +939,7 @@ CONSTVEL_MDL::CONSTVEL_MDL( double positionMeasureVarianceX,
     double pVx = positionMeasureVarianceX;
     double pVy = positionMeasureVarianceY;
     double gV = gradientMeasureVariance;
-    MATRIX Q (4, 4 );
+    fixedMATRIX< 4, 4 > Q;
 
 
     m_R.set(  pVx, 0.,
@@ -506,10 +961,35 @@ CONSTVEL_MDL::CONSTVEL_MDL( double positionMeasureVarianceX,
     m_startP.print();
 #endif
 
+    m_startCov = new CONSTVEL_COV( m_startP, m_processVariance, m_R );
+
     type = 2;
 }
 
 
+/*-------------------------------------------------------------------*
+ | CONSTVEL_MDL::~CONSTVEL_MDL() -- destructor for the CONSTVEL_MDL
+ *-------------------------------------------------------------------*/
+
+CONSTVEL_MDL::~CONSTVEL_MDL()
+{
+
+
+    CONSTVEL_COV *cov;
+    CONSTVEL_COV *next;
+
+    for( cov = m_startCov; cov != 0; cov = next )
+    {
+        next = cov->m_next.load( std::memory_order_relaxed );
+        if( next == cov )
+        {
+            next = 0;
+        }
+        delete cov;
+    }
+}
+
+
 /*--------------------------------------------------------*
  * getTrackColor( int trackId )
  *--------------------------------------------------------*/
@@ -531,11 +1011,11 @@ void CORNER_TRACK_MHT::describe(int spaces)
 {
 
 
-    PTR_INTO_ptrDLIST_OF< T_HYPO > tHypoPtr;
     PTR_INTO_iDLIST_OF< GROUP > groupPtr;
     PTR_INTO_iDLIST_OF< REPORT > reportPtr;
     PTR_INTO_iDLIST_OF< T_TREE > tTreePtr;
     int k;
+    int i;
 
     Indent( spaces );
     std::cout << "MHT ";
@@ -558,7 +1038,7 @@ void CORNER_TRACK_MHT::describe(int spaces)
     std::cout << "active tHypo's:";
     k = 0;
 
-    LOOP_DLIST( tHypoPtr, m_activeTHypoList )
+    for( i = 0; i < (int)m_activeTHypoList.size(); i++ )
     {
         if( k++ >= 3 )
         {
@@ -569,7 +1049,7 @@ void CORNER_TRACK_MHT::describe(int spaces)
         }
 
         std::cout << " ";
-        (*tHypoPtr).print();
+        m_activeTHypoList[ i ]->print();
     }
     std::cout << std::endl;
 
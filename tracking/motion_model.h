@@ -44,31 +44,37 @@
  *                                                                   *
  *                          CONSTVEL_STATE                           *
  *                                                                   *
- *   The member variables of CONSTVEL_STATEs can be divided into two *
- *   groups.  The first group contains the normal, Kalman filter     *
- *   values that describe a state estimate: the estimate itself, the *
- *   covariance matrix, and the log of the likelihood.               *
+ *   A CONSTVEL_STATE holds the state estimate itself, the log of    *
+ *   its likelihood, and a pointer to the CONSTVEL_COV that goes     *
+ *   with it.  The prediction for the next step is computed from     *
+ *   these when it's asked for.                                      *
  *                                                                   *
- *   The second group contains all the parts of the Kalman filter    *
- *   calculations that can be computed without reference to a        *
- *   report.  These will be used in validating reports to the        *
- *   CORNER_TRACK, and in computing the resulting state estimates    *
- *   (and CONSTVEL_STATE objects).                                   *
+ *                           CONSTVEL_COV                            *
  *                                                                   *
- *   This second group of variables is not computed at the time of   *
- *   the CONSTVEL_STATE's construction, since the CONSTVEL_STATE     *
- *   might be pruned away from the tree before it has a chance to    *
- *   have any reports validated to it.  Instead, they are computed   *
- *   by the member function setup().                                 *
+ *   A CONSTVEL_COV holds the covariance of a state estimate, and    *
+ *   all the parts of the Kalman filter calculations that follow     *
+ *   from it without reference to a report: the time step (m_ds),    *
+ *   the inverse innovation covariance, the filter gain, and the     *
+ *   covariance for the next state.  These will be used in           *
+ *   validating reports to the CORNER_TRACK, and in computing the    *
+ *   resulting state estimates (and CONSTVEL_STATE objects).         *
  *                                                                   *
- *   The first thing that setup() does is to decide the length of    *
- *   the time step to use.  The time step is chosen such that it     *
- *   makes the predicted state estimate land in a neighboring pixel. *
- *   The time step is stored in the member variable m_ds.            *
+ *   None of this depends on the values of the reports.  Every       *
+ *   CORNER_TRACK starts with the same covariance, and a step that   *
+ *   skips a report updates it the same way as a step that detects   *
+ *   one.  So the covariance only depends on how many steps old the  *
+ *   CORNER_TRACK is.  Each CONSTVEL_MDL keeps a single chain of     *
+ *   CONSTVEL_COVs, one for each age, and all the states of that age *
+ *   share it.  A link is only added to the chain the first time a   *
+ *   state gets that old.  Once the covariance stops changing, the   *
+ *   last link of the chain points to itself.                        *
  *                                                                   *
  *                           CONSTVEL_MDL                            *
  *                                                                   *
  *   The CONSTVEL_MDL class makes new CONSTVEL_STATEs from old ones. *
+ *   When a report is involved, it first only works out the          *
+ *   likelihood, and the CONSTVEL_STATE is made later, for the few   *
+ *   track hypotheses that survive pruning.                          *
  *
  *   beginNewStates() tells how many new state should be generated   *
  *   We have restricted new track initiation to just the first frame *
@@ -113,6 +119,8 @@
 #include <math.h>
 #include <cstdio>		// for  sprintf
 #include <list>			// for std::list<>
+#include <atomic>		// for std::atomic<>
+#include <mutex>		// for std::mutex
 
 static int g_numTracks;
 
@@ -121,6 +129,7 @@ class CORNER_TRACK_MDL;
 class CONSTPOS_STATE;
 class CONSTPOS_MDL;
 class CONSTVEL_STATE;
+class CONSTVEL_COV;
 class CONSTVEL_MDL;
 class CONSTCURV_STATE;
 class CONSTCURV_MDL;
@@ -150,7 +159,7 @@ private:
     double m_falarmLogLikelihood;    // log of the likelihood that
                                      // this report is a false alarm
                                      // (not really part of a CORNER_TRACK)
-    MATRIX m_z;                      // (x, dx, y, dy)
+    fixedMATRIX< 2, 1 > m_z;         // (x, y)
 
 public:
     int m_frameNo;
@@ -160,7 +169,7 @@ public:
                      const int &f, const size_t &cornerID):
         MDL_REPORT(),
         m_falarmLogLikelihood( falarmLogLikelihood ),
-        m_z( 2, 1 ),
+        m_z(),
         m_frameNo(f),
         m_cornerID(cornerID)
 
@@ -192,7 +201,7 @@ public:
         return m_falarmLogLikelihood;
     }
 
-    MATRIX &getZ()
+    fixedMATRIX< 2, 1 > &getZ()
     {
         return m_z;
     }
@@ -250,9 +259,6 @@ class CONSTVEL_MDL: public CORNER_TRACK_MDL
 private:
     double m_lambda_x;
     double m_startLogLikelihood;     // likelihood of a CORNER_TRACK starting
-    double m_endLogLikelihood;       // likelihood of a CORNER_TRACK ending
-    double m_continueLogLikelihood;  // likelihood of a CORNER_TRACK not
-                                     //   ending
     double m_skipLogLikelihood;      // likelihood of not detecting a
                                      //   CORNER_TRACK that hasn't ended
     double m_detectLogLikelihood;    // likelihood of detecting a
@@ -265,9 +271,13 @@ private:
     double m_processVariance;        // process noise
     double m_intensityVariance;
     double m_stateVariance;
-    MATRIX m_R;                      // measurement covariance
-    MATRIX m_startP;                 // covariance matrix to use at
+    fixedMATRIX< 2, 2 > m_R;         // measurement covariance
+    fixedMATRIX< 4, 4 > m_startP;    // covariance matrix to use at
                                      //   start of a CORNER_TRACK
+    CONSTVEL_COV *m_startCov;        // first link in the chain of
+                                     //   covariances (see
+                                     //   CONSTVEL_COV)
+    std::mutex m_covMutex;           // held while adding to the chain
 public:
 
     CONSTVEL_MDL( double positionMeasureVarianceX,
@@ -280,12 +290,17 @@ public:
                   double detectProb,
                   double stateVar,
                   double maxDistance);
+    ~CONSTVEL_MDL();
 
     virtual int beginNewStates( MDL_STATE *mdlState,
                                 MDL_REPORT *mdlReport );
     virtual MDL_STATE *getNewState( int stateNum,
                                     MDL_STATE *mdlState,
                                     MDL_REPORT *mdlReport );
+    virtual int getNewStateLogLikelihood( int stateNum,
+                                          MDL_STATE *mdlState,
+                                          MDL_REPORT *mdlReport,
+                                          double *logLikelihood );
     virtual double getEndLogLikelihood( MDL_STATE * );
     virtual double getContinueLogLikelihood( MDL_STATE * );
     virtual double getSkipLogLikelihood( MDL_STATE *mdlState );
@@ -293,12 +308,65 @@ public:
     {
         return m_detectLogLikelihood;
     }
+    virtual void validate( MDL_STATE **mdlStates, int numStates,
+                           MDL_REPORT **mdlReports, int numReports,
+                           std::vector< int > &valid );
     virtual double getStateX(MDL_STATE *s);
     virtual double getStateY(MDL_STATE *s);
  private:
 
     CONSTVEL_STATE* getNextState( CONSTVEL_STATE *state,
                                   CONSTPOS_REPORT *report );
+    double getDistance( CONSTVEL_STATE *state,
+                        CONSTPOS_REPORT *report,
+                        fixedMATRIX< 2, 1 > &v );
+    CONSTVEL_COV *getNextCov( CONSTVEL_COV *cov );
+
+    CONSTVEL_MDL( const CONSTVEL_MDL & );
+    CONSTVEL_MDL &operator=( const CONSTVEL_MDL & );
+};
+
+/*-------------------------------------------------------------------*
+ *
+ * CONSTVEL_COV -- covariance of a CORNER_TRACK's state estimate, and
+ *                 the parts of the Kalman filter that follow from it
+ *
+ * These are shared by all the CONSTVEL_STATEs of the same age (see
+ * the comments at the top of this file).  They are computed once,
+ * when the CONSTVEL_COV is made, and never change after that.
+ *
+ *-------------------------------------------------------------------*/
+
+class CONSTVEL_COV
+{
+    friend class CONSTVEL_STATE;
+    friend class CONSTVEL_MDL;
+
+private:
+
+    fixedMATRIX< 4, 4 > m_P;         // covariance matrix
+
+    double m_ds;                     // "time" step until the next state
+    fixedMATRIX< 4, 4 > m_F;         // state transition matrix for m_ds
+    double m_logLikelihoodCoef;      // part of likelihood calculation
+                                     //   that's independent of the
+                                     //   inovation
+    fixedMATRIX< 2, 2 > m_Sinv;      // inverse of the innovation
+                                     //   covariance
+    fixedMATRIX< 4, 2 > m_W;         // filter gain
+    fixedMATRIX< 4, 4 > m_nextP;     // updated state covariance
+                                     //   (covariance for next state)
+
+    std::atomic< CONSTVEL_COV * > m_next;
+                                     // link for states one step older
+                                     //   (0 until it's needed)
+
+    CONSTVEL_COV( const fixedMATRIX< 4, 4 > &P,
+                  double processVariance,
+                  const fixedMATRIX< 2, 2 > &R );
+
+    CONSTVEL_COV( const CONSTVEL_COV & );
+    CONSTVEL_COV &operator=( const CONSTVEL_COV & );
 };
 
 /*-------------------------------------------------------------------*
@@ -319,8 +387,9 @@ class CONSTVEL_STATE: public MDL_STATE
 
 private:
 
-    MATRIX m_x;                      // state estimate (x, dx, y, dy)
-    MATRIX m_P;                      // covariance matrix
+    fixedMATRIX< 4, 1 > m_x;         // state estimate (x, dx, y, dy)
+    CONSTVEL_COV *m_cov;             // covariance, and the parts of the
+                                     //   filter that follow from it
     double m_logLikelihood;          // likelihood that this state
                                      //   is the true state of the
                                      //   CORNER_TRACK after the state
@@ -328,21 +397,6 @@ private:
                                      //   CONSTVEL_MDL::getNewState())
 
     int m_numSkipped;
-    int m_hasBeenSetup;              // 0 before the following variables
-                                     //   have been filled in, 1 after
-
-    double m_ds;                     // "time" step until the next state
-                                     //   (chosen so that the next state
-                                     //   lands in a neighboring pixel)
-    double m_logLikelihoodCoef;      // part of likelihood calculation
-                                     //   that's independent of the
-                                     //   inovation
-    MATRIX *m_Sinv;                  // inverse of the innovation
-                                     //   covariance
-    MATRIX *m_W;                     // filter gain
-    MATRIX *m_nextP;                 // updated state covariance
-                                     //   (covariance for next state)
-    MATRIX *m_x1;                    // state prediction
 
 private:
 
@@ -351,20 +405,14 @@ private:
                     const double &dx,
                     const double &y,
                     const double &dy,
-                    MATRIX &P,
+                    CONSTVEL_COV *cov,
                     const double &logLikelihood,
                     const int &numSkipped):
         MDL_STATE( mdl ),
+        m_x(),
+        m_cov( cov ),
         m_logLikelihood( logLikelihood ),
-        m_hasBeenSetup( 0 ),
-        m_numSkipped(numSkipped),
-        m_x(4,1),
-        m_P(P),
-        m_ds( 0 ),
-        m_x1( 0 ),
-        m_nextP( 0 ),
-        m_Sinv( 0 ),
-        m_W( 0 )
+        m_numSkipped(numSkipped)
     {
         m_x(0)=x;
         m_x(1)=dx;
@@ -376,92 +424,42 @@ private:
     CONSTVEL_STATE( const CONSTVEL_STATE &src ):
         MDL_STATE( src.getMdl() ),
         m_x( src.m_x ),
-        m_P( src.m_P ),
+        m_cov( src.m_cov ),
         m_logLikelihood( src.m_logLikelihood ),
-        m_hasBeenSetup( 0 ),
-        m_numSkipped(src.m_numSkipped),
-        m_ds( 0 ),
-        m_x1( 0 ),
-        m_nextP( 0 ),
-        m_Sinv( 0 ),
-        m_W( 0 )
+        m_numSkipped(src.m_numSkipped)
     {
     }
 
 
 private:
 
-    void setup( double processVariance, const MATRIX &R );
-
-    void cleanup()
-    {
-
-
-        if( m_hasBeenSetup )
-        {
-            delete m_x1;
-            m_x1 = 0;
-            delete m_nextP;
-            m_nextP = 0;
-            delete m_Sinv;
-            m_Sinv = 0;
-            delete m_W;
-            m_W = 0;
-
-            m_hasBeenSetup = 0;
-        }
-    }
-
-
     int getNumSkipped()
     {
         return m_numSkipped;
     }
-    double getLogLikelihoodCoef()
+    CONSTVEL_COV *getCov()
     {
-        checkSetup();
-        return m_logLikelihoodCoef;
+        return m_cov;
     }
-    MATRIX &getPrediction()
+    double getLogLikelihoodCoef()
     {
-        checkSetup();
-        return *m_x1;
+        return m_cov->m_logLikelihoodCoef;
     }
-    MATRIX &getNextP()
+    fixedMATRIX< 4, 1 > getPrediction()
     {
-        checkSetup();
-        return *m_nextP;
+        return m_cov->m_F * m_x;
     }
-    MATRIX &getSinv()
+    const fixedMATRIX< 2, 2 > &getSinv()
     {
-        checkSetup();
-        return *m_Sinv;
+        return m_cov->m_Sinv;
     }
-    MATRIX &getW()
+    const fixedMATRIX< 4, 2 > &getW()
     {
-        checkSetup();
-        return *m_W;
+        return m_cov->m_W;
     }
 
-#ifdef TSTBUG
-
-    void checkSetup()
-    {
-        assert( m_hasBeenSetup );
-        //  THROW_ERR( "Trying to get derived info from a CONSTPOS state"
-        //             " that hasn't been setup()" )
-    }
-
-#else
-    void checkSetup() {}
-#endif
-
 public:
 
-    ~CONSTVEL_STATE()
-    {
-        cleanup();    //SHOULD THIS BE PRIVATE?
-    }
     virtual double getLogLikelihood()
     {
         return m_logLikelihood;
@@ -500,29 +498,24 @@ public:
 
     double getX1()
     {
-        checkSetup();
-        return (*m_x1)( 0 );
+        return getPrediction()( 0 );
     }
     double getDX1()
     {
-        checkSetup();
-        return (*m_x1)( 1 );
+        return getPrediction()( 1 );
     }
     double getY1()
     {
-        checkSetup();
-        return (*m_x1)( 2 );
+        return getPrediction()( 2 );
     }
     double getDY1()
     {
-        checkSetup();
-        return (*m_x1)( 3 );
+        return getPrediction()( 3 );
     }
 
     double getDS()
     {
-        checkSetup();
-        return m_ds;
+        return m_cov->m_ds;
     }
 };
 
@@ -9,6 +9,8 @@
 #include <vector>	// for std::vector<>
 #include "param.h"       //  contains values of needed parameters 
 #include "motion_model.h"
+#include "mht/assign.h"
+#include "mht/apqueue.h"
 
 #include <stdexcept>	// for std::runtime_error
 
@@ -29,6 +31,8 @@ int g_time;
 void PrintSyntax()
 {
     std::cerr << "trackCorners -o OUTFILE [-p PARAM_FILE] [-d DIRNAME] -i INFILE\n"
+              << "             [-a METHOD] [--inherit-duals | -u] [--lower-bounds | -b]\n"
+              << "             [-t NUM_THREADS]\n"
               << "             [--syntax | -x] [--help | -h]\n";
 }
 
@@ -49,6 +53,22 @@ void PrintHelp()
     std::cerr << "-d --dir      DIRNAME\n"
               << "DIRNAME to prepend to the corner files.  Default is .\n\n";
 
+    std::cerr << "-a  --assign  METHOD\n"
+              << "Algorithm for solving assignment problems, either 'hungarian'\n"
+              << "or 'shortest-path'.  Defaults to 'hungarian'.\n\n";
+
+    std::cerr << "-u  --inherit-duals\n"
+              << "Solve each ranked-assignment subproblem by shortest paths, starting\n"
+              << "from the dual variables of the solution it was partitioned from.\n\n";
+
+    std::cerr << "-b  --lower-bounds\n"
+              << "Give each ranked-assignment subproblem a lower bound on its cost, so\n"
+              << "that ones which can't produce a good enough hypothesis aren't solved.\n\n";
+
+    std::cerr << "-t  --threads NUM_THREADS\n"
+              << "Number of threads used to grow the leaves of the track trees and to\n"
+              << "make new group hypotheses.  Defaults to 1.\n\n";
+
     std::cerr << "-x  --syntax\n"
               << "Print the syntax for running this program.\n\n";
 
@@ -75,6 +95,7 @@ int main(int argc, char **argv)
     std::string paramFileName = "./Parameters";
     std::string inputFileName = "";
     std::string dirName = ".";
+    int numThreads = 1;
 
     int OptionIndex = 0;
     int OptionChar = 0;
@@ -87,12 +108,16 @@ int main(int argc, char **argv)
         {"param", 1, NULL, 'p'},
         {"input", 1, NULL, 'i'},
 	{"dir", 1, NULL, 'd'},
+        {"assign", 1, NULL, 'a'},
+        {"inherit-duals", 0, NULL, 'u'},
+        {"lower-bounds", 0, NULL, 'b'},
+        {"threads", 1, NULL, 't'},
         {"syntax", 0, NULL, 'x'},
         {"help", 0, NULL, 'h'},
         {0, 0, 0, 0}
     };
 
-    while ((OptionChar = getopt_long(argc, argv, "o:p:i:d:xh", TheLongOptions, &OptionIndex)) != -1)
+    while ((OptionChar = getopt_long(argc, argv, "o:p:i:d:a:ubt:xh", TheLongOptions, &OptionIndex)) != -1)
     {
         switch (OptionChar)
         {
@@ -108,6 +133,34 @@ int main(int argc, char **argv)
 	case 'd':
 	    dirName = optarg;
 	    break;
+        case 'a':
+            if (strcmp(optarg, "hungarian") == 0)
+            {
+                SetAssignmentMethod(HUNGARIAN_ASSIGN);
+            }
+            else if (strcmp(optarg, "shortest-path") == 0)
+            {
+                SetAssignmentMethod(SHORTEST_PATH_ASSIGN);
+            }
+            else
+            {
+                std::cerr << "ERROR: Unknown assignment method: " << optarg << std::endl;
+                OptionError = true;
+            }
+            break;
+        case 'u':
+            SetDualInheritance(1);
+            break;
+        case 'b':
+            SetLowerBounds(1);
+            break;
+        case 't':
+            if (sscanf(optarg, "%d", &numThreads) != 1 || numThreads < 1)
+            {
+                std::cerr << "ERROR: Bad number of threads: " << optarg << std::endl;
+                OptionError = true;
+            }
+            break;
         case 'x':
             PrintSyntax();
             return(1);
@@ -216,6 +269,7 @@ int main(int argc, char **argv)
                           param.minGHypoRatio,
                           param.maxGHypos,
                           mdl );
+    mht.setNumThreads(numThreads);
 
 
 